@@ -249,6 +249,72 @@ static TranslationBlock *tb_htable_lookup(CPUState *cpu, vaddr pc,
     return qht_lookup_custom(&tb_ctx.htable, &desc, h, tb_lookup_cmp);
 }
 
+CPUJumpCache *tb_jmp_cache_new(unsigned bits)
+{
+    CPUJumpCache *jc;
+
+    jc = g_malloc0(sizeof(*jc) + sizeof(jc->array[0]) * ((size_t)1 << bits));
+    jc->bits = bits;
+    return jc;
+}
+
+static inline void tb_jmp_cache_set(CPUJumpCache *jc, uint32_t hash,
+                                    vaddr pc, TranslationBlock *tb)
+{
+    if (qatomic_read(&jc->array[hash].tb)) {
+        qatomic_set(&jc->conflicts, jc->conflicts + 1);
+    }
+    jc->array[hash].pc = pc;
+    qatomic_set(&jc->array[hash].tb, tb);
+}
+
+/*
+ * Called by the owning CPU once a window of misses has been seen.
+ * Grow the jump cache if live entries are frequently evicted by other
+ * TBs; shrink it if it is mostly empty, since every TLB flush clears
+ * the whole cache.  A resized cache starts out empty.
+ */
+static CPUJumpCache *tb_jmp_cache_resize_check(CPUState *cpu,
+                                               CPUJumpCache *jc)
+{
+    size_t size = tb_jmp_cache_size(jc);
+    size_t lookups, conflicts;
+    unsigned bits = jc->bits;
+    CPUJumpCache *new_jc;
+
+    lookups = (jc->hits - jc->window_hits) + (jc->misses - jc->window_misses);
+    conflicts = jc->conflicts - jc->window_conflicts;
+
+    if (conflicts * 16 > lookups) {
+        bits = MIN(bits + 1, TB_JMP_CACHE_MAX_BITS);
+    } else if (conflicts * 256 < lookups && bits > TB_JMP_CACHE_MIN_BITS) {
+        size_t used = 0;
+
+        for (size_t i = 0; i < size; i++) {
+            used += qatomic_read(&jc->array[i].tb) != NULL;
+        }
+        if (used < size / 8) {
+            bits--;
+        }
+    }
+
+    jc->window_hits = jc->hits;
+    jc->window_misses = jc->misses;
+    jc->window_conflicts = jc->conflicts;
+    if (bits == jc->bits) {
+        return jc;
+    }
+
+    new_jc = tb_jmp_cache_new(bits);
+    new_jc->hits = new_jc->window_hits = jc->hits;
+    new_jc->misses = new_jc->window_misses = jc->misses;
+    new_jc->conflicts = new_jc->window_conflicts = jc->conflicts;
+    new_jc->resizes = jc->resizes + 1;
+    qatomic_rcu_set(&cpu->tb_jmp_cache, new_jc);
+    g_free_rcu(jc, rcu);
+    return new_jc;
+}
+
 /* Might cause an exception, so have a longjmp destination ready */
 static inline TranslationBlock *tb_lookup(CPUState *cpu, vaddr pc,
                                           uint64_t cs_base, uint32_t flags,
@@ -261,8 +327,8 @@ static inline TranslationBlock *tb_lookup(CPUState *cpu, vaddr pc,
     /* we should never be trying to look up an INVALID tb */
     tcg_debug_assert(!(cflags & CF_INVALID));
 
-    hash = tb_jmp_cache_hash_func(pc);
     jc = cpu->tb_jmp_cache;
+    hash = tb_jmp_cache_hash_func(jc, pc);
 
     tb = qatomic_read(&jc->array[hash].tb);
     if (likely(tb &&
@@ -270,16 +336,23 @@ static inline TranslationBlock *tb_lookup(CPUState *cpu, vaddr pc,
                tb->cs_base == cs_base &&
                tb->flags == flags &&
                tb_cflags(tb) == cflags)) {
+        qatomic_set(&jc->hits, jc->hits + 1);
         goto hit;
     }
 
+    qatomic_set(&jc->misses, jc->misses + 1);
+    if (unlikely(jc->misses - jc->window_misses >=
+                 tb_jmp_cache_size(jc) / 4)) {
+        jc = tb_jmp_cache_resize_check(cpu, jc);
+        hash = tb_jmp_cache_hash_func(jc, pc);
+    }
+
     tb = tb_htable_lookup(cpu, pc, cs_base, flags, cflags);
     if (tb == NULL) {
         return NULL;
     }
 
-    jc->array[hash].pc = pc;
-    qatomic_set(&jc->array[hash].tb, tb);
+    tb_jmp_cache_set(jc, hash, pc, tb);
 
 hit:
     /*
@@ -1004,17 +1077,30 @@ cpu_exec_loop(CPUState *cpu, SyncClocks *sc)
                 uint32_t h;
 
                 mmap_lock();
+#ifdef CONFIG_USER_ONLY
+                /*
+                 * Translation is serialized by mmap_lock.  When several
+                 * threads miss on the same code at once, e.g. right after
+                 * a large exec or dlopen, the others will have waited for
+                 * the first one to translate it: pick that result up
+                 * instead of translating again only to discard it.
+                 */
+                tb = tb_htable_lookup(cpu, pc, cs_base, flags, cflags);
+                if (tb == NULL) {
+                    tb = tb_gen_code(cpu, pc, cs_base, flags, cflags);
+                }
+#else
                 tb = tb_gen_code(cpu, pc, cs_base, flags, cflags);
+#endif
                 mmap_unlock();
 
                 /*
                  * We add the TB in the virtual pc hash table
                  * for the fast lookup
                  */
-                h = tb_jmp_cache_hash_func(pc);
                 jc = cpu->tb_jmp_cache;
-                jc->array[h].pc = pc;
-                qatomic_set(&jc->array[h].tb, tb);
+                h = tb_jmp_cache_hash_func(jc, pc);
+                tb_jmp_cache_set(jc, h, pc, tb);
             }
 
 #ifndef CONFIG_USER_ONLY
@@ -1096,7 +1182,7 @@ bool tcg_exec_realizefn(CPUState *cpu, Error **errp)
         tcg_target_initialized = true;
     }
 
-    cpu->tb_jmp_cache = g_new0(CPUJumpCache, 1);
+    cpu->tb_jmp_cache = tb_jmp_cache_new(TB_JMP_CACHE_BITS);
     tlb_init(cpu);
 #ifndef CONFIG_USER_ONLY
     tcg_iommu_init_notifier_list(cpu);
@@ -158,14 +158,15 @@ static void tlb_window_reset(CPUTLBDesc *desc, int64_t ns,
 static void tb_jmp_cache_clear_page(CPUState *cpu, vaddr page_addr)
 {
     CPUJumpCache *jc = cpu->tb_jmp_cache;
-    int i, i0;
+    int i, i0, n;
 
     if (unlikely(!jc)) {
         return;
     }
 
-    i0 = tb_jmp_cache_hash_page(page_addr);
-    for (i = 0; i < TB_JMP_PAGE_SIZE; i++) {
+    i0 = tb_jmp_cache_hash_page(jc, page_addr);
+    n = 1 << tb_jmp_cache_page_bits(jc);
+    for (i = 0; i < n; i++) {
         qatomic_set(&jc->array[i0 + i].tb, NULL);
     }
 }
@@ -290,6 +291,7 @@ static void tlb_mmu_flush_locked(CPUTLBDesc *desc, CPUTLBDescFast *fast)
     desc->n_used_entries = 0;
     desc->large_page_addr = -1;
     desc->large_page_mask = -1;
+    desc->map_fill_addr = -1;
     desc->vindex = 0;
     memset(fast->table, -1, sizeof_tlb(fast));
     memset(desc->vtable, -1, sizeof(desc->vtable));
@@ -356,21 +358,115 @@ void tlb_destroy(CPUState *cpu)
     }
 }
 
-/* flush_all_helper: run fn across all cpus
- *
- * If the wait flag is set then the src cpu's helper will be queued as
- * "safe" work and the loop exited creating a synchronisation point
- * where all queued work will be finished before execution starts
- * again.
+static void tlb_flush_by_mmuidx_async_work(CPUState *cpu,
+                                           run_on_cpu_data data);
+static void tlb_flush_range_by_mmuidx_async_0(CPUState *cpu,
+                                              CPUTLBFlushRange d);
+
+/*
+ * Perform all of the flushes that other cpus have queued for @cpu.
+ */
+static void tlb_flush_pending_async_work(CPUState *cpu, run_on_cpu_data data)
+{
+    CPUTLBCommon *c = &cpu->neg.tlb.c;
+    CPUTLBFlushRange pending[CPU_TLB_PENDING_FLUSHES];
+    uint16_t full;
+    unsigned i, n;
+
+    qemu_spin_lock(&c->lock);
+    full = c->pending_full;
+    n = c->n_pending;
+    memcpy(pending, c->pending, n * sizeof(pending[0]));
+    c->pending_full = 0;
+    c->n_pending = 0;
+    c->pending_queued = false;
+    qemu_spin_unlock(&c->lock);
+
+    if (full) {
+        tlb_flush_by_mmuidx_async_work(cpu, RUN_ON_CPU_HOST_INT(full));
+    }
+    for (i = 0; i < n; i++) {
+        pending[i].idxmap &= ~full;
+        if (pending[i].idxmap) {
+            tlb_flush_range_by_mmuidx_async_0(cpu, pending[i]);
+        }
+    }
+}
+
+static bool tlb_flush_range_merge(CPUTLBFlushRange *p,
+                                  const CPUTLBFlushRange *d)
+{
+    vaddr p_end = p->addr + p->len;
+    vaddr d_end = d->addr + d->len;
+
+    if (p->idxmap != d->idxmap || p->bits != d->bits ||
+        p_end < p->addr || d_end < d->addr ||
+        d->addr > p_end || p->addr > d_end) {
+        return false;
+    }
+    p->addr = MIN(p->addr, d->addr);
+    p->len = MAX(p_end, d_end) - p->addr;
+    return true;
+}
+
+/*
+ * Queue flush @d for @cpu, where a @d.len of 0 requests a full flush of
+ * @d.idxmap.  Requests are merged with those that @cpu has not yet
+ * performed, so that a burst of shootdowns from other cpus costs @cpu
+ * one work item instead of one per request.
  */
-static void flush_all_helper(CPUState *src, run_on_cpu_func fn,
-                             run_on_cpu_data d)
+static void tlb_flush_queue(CPUState *cpu, CPUTLBFlushRange d)
+{
+    CPUTLBCommon *c = &cpu->neg.tlb.c;
+    bool queue;
+    unsigned i;
+
+    qemu_spin_lock(&c->lock);
+
+    d.idxmap &= ~c->pending_full;
+    if (d.len == 0) {
+        c->pending_full |= d.idxmap;
+    } else if (d.idxmap) {
+        for (i = 0; i < c->n_pending; i++) {
+            if (tlb_flush_range_merge(&c->pending[i], &d)) {
+                break;
+            }
+        }
+        if (i < c->n_pending) {
+            /* Merged. */
+        } else if (i < CPU_TLB_PENDING_FLUSHES) {
+            c->pending[c->n_pending++] = d;
+        } else {
+            /* Too many distinct ranges: fall back to full flushes. */
+            c->pending_full |= d.idxmap;
+            for (i = 0; i < c->n_pending; i++) {
+                c->pending_full |= c->pending[i].idxmap;
+            }
+            c->n_pending = 0;
+        }
+    }
+
+    queue = !c->pending_queued;
+    c->pending_queued = true;
+    if (!queue) {
+        qatomic_set(&c->merged_flush_count, c->merged_flush_count + 1);
+    }
+
+    qemu_spin_unlock(&c->lock);
+
+    if (queue) {
+        async_run_on_cpu(cpu, tlb_flush_pending_async_work, RUN_ON_CPU_NULL);
+    }
+}
+
+/* Queue flush @d for all cpus except @src. */
+static void tlb_flush_queue_others(CPUState *src, CPUTLBFlushRange d)
 {
     CPUState *cpu;
 
     CPU_FOREACH(cpu) {
         if (cpu != src) {
-            async_run_on_cpu(cpu, fn, d);
+            tlb_flush_queue(cpu, d);
         }
     }
 }
@@ -435,7 +531,7 @@ void tlb_flush_by_mmuidx_all_cpus_synced(CPUState *src_cpu, uint16_t idxmap)
 
     tlb_debug("mmu_idx: 0x%"PRIx16"\n", idxmap);
 
-    flush_all_helper(src_cpu, fn, RUN_ON_CPU_HOST_INT(idxmap));
+    tlb_flush_queue_others(src_cpu, (CPUTLBFlushRange){ .idxmap = idxmap });
     async_safe_run_on_cpu(src_cpu, fn, RUN_ON_CPU_HOST_INT(idxmap));
 }
 
@@ -632,30 +728,23 @@ void tlb_flush_page_by_mmuidx_all_cpus_synced(CPUState *src_cpu,
     /* This should already be page aligned */
     addr &= TARGET_PAGE_MASK;
 
+    tlb_flush_queue_others(src_cpu, (CPUTLBFlushRange){
+        .addr = addr,
+        .len = TARGET_PAGE_SIZE,
+        .idxmap = idxmap,
+        .bits = TARGET_LONG_BITS,
+    });
+
     /*
      * Allocate memory to hold addr+idxmap only when needed.
      * See tlb_flush_page_by_mmuidx for details.
      */
     if (idxmap < TARGET_PAGE_SIZE) {
-        flush_all_helper(src_cpu, tlb_flush_page_by_mmuidx_async_1,
-                         RUN_ON_CPU_TARGET_PTR(addr | idxmap));
         async_safe_run_on_cpu(src_cpu, tlb_flush_page_by_mmuidx_async_1,
                               RUN_ON_CPU_TARGET_PTR(addr | idxmap));
     } else {
-        CPUState *dst_cpu;
         TLBFlushPageByMMUIdxData *d;
 
-        /* Allocate a separate data block for each destination cpu.  */
-        CPU_FOREACH(dst_cpu) {
-            if (dst_cpu != src_cpu) {
-                d = g_new(TLBFlushPageByMMUIdxData, 1);
-                d->addr = addr;
-                d->idxmap = idxmap;
-                async_run_on_cpu(dst_cpu, tlb_flush_page_by_mmuidx_async_2,
-                                 RUN_ON_CPU_HOST_PTR(d));
-            }
-        }
-
         d = g_new(TLBFlushPageByMMUIdxData, 1);
         d->addr = addr;
         d->idxmap = idxmap;
@@ -719,15 +808,8 @@ static void tlb_flush_range_locked(CPUState *cpu, int midx,
     }
 }
 
-typedef struct {
-    vaddr addr;
-    vaddr len;
-    uint16_t idxmap;
-    uint16_t bits;
-} TLBFlushRangeData;
-
 static void tlb_flush_range_by_mmuidx_async_0(CPUState *cpu,
-                                              TLBFlushRangeData d)
+                                              CPUTLBFlushRange d)
 {
     int mmu_idx;
 
@@ -748,7 +830,7 @@ static void tlb_flush_range_by_mmuidx_async_0(CPUState *cpu,
      * If the length is larger than the jump cache size, then it will take
      * longer to clear each entry individually than it will to clear it all.
      */
-    if (d.len >= (TARGET_PAGE_SIZE * TB_JMP_CACHE_SIZE)) {
+    if (d.len >= TARGET_PAGE_SIZE * tb_jmp_cache_size(cpu->tb_jmp_cache)) {
         tcg_flush_jmp_cache(cpu);
         return;
     }
@@ -767,7 +849,7 @@ static void tlb_flush_range_by_mmuidx_async_0(CPUState *cpu,
 static void tlb_flush_range_by_mmuidx_async_1(CPUState *cpu,
                                               run_on_cpu_data data)
 {
-    TLBFlushRangeData *d = data.host_ptr;
+    CPUTLBFlushRange *d = data.host_ptr;
     tlb_flush_range_by_mmuidx_async_0(cpu, *d);
     g_free(d);
 }
@@ -776,7 +858,7 @@ void tlb_flush_range_by_mmuidx(CPUState *cpu, vaddr addr,
                                vaddr len, uint16_t idxmap,
                                unsigned bits)
 {
-    TLBFlushRangeData d;
+    CPUTLBFlushRange d;
 
     assert_cpu_is_self(cpu);
 
@@ -815,8 +897,7 @@ void tlb_flush_range_by_mmuidx_all_cpus_synced(CPUState *src_cpu,
                                                uint16_t idxmap,
                                                unsigned bits)
 {
-    TLBFlushRangeData d, *p;
-    CPUState *dst_cpu;
+    CPUTLBFlushRange d, *p;
 
     /*
      * If all bits are significant, and len is small,
@@ -838,14 +919,7 @@ void tlb_flush_range_by_mmuidx_all_cpus_synced(CPUState *src_cpu,
     d.idxmap = idxmap;
     d.bits = bits;
 
-    /* Allocate a separate data block for each destination cpu.  */
-    CPU_FOREACH(dst_cpu) {
-        if (dst_cpu != src_cpu) {
-            p = g_memdup(&d, sizeof(d));
-            async_run_on_cpu(dst_cpu, tlb_flush_range_by_mmuidx_async_1,
-                             RUN_ON_CPU_HOST_PTR(p));
-        }
-    }
+    tlb_flush_queue_others(src_cpu, d);
 
     p = g_memdup(&d, sizeof(d));
     async_safe_run_on_cpu(src_cpu, tlb_flush_range_by_mmuidx_async_1,
@@ -1057,6 +1131,11 @@ void tlb_set_page_full(CPUState *cpu, int mmu_idx,
     } else {
         sz = (hwaddr)1 << full->lg_page_size;
         tlb_add_large_page(cpu, mmu_idx, addr, sz);
+        if (full->lg_map_size > TARGET_PAGE_BITS &&
+            full->lg_map_size <= full->lg_page_size) {
+            desc->map_fill_addr = addr;
+            desc->map_fill = *full;
+        }
     }
     addr_page = addr & TARGET_PAGE_MASK;
     paddr_page = full->phys_addr & TARGET_PAGE_MASK;
@@ -1221,6 +1300,41 @@ void tlb_set_page(CPUState *cpu, vaddr addr,
                             prot, mmu_idx, size);
 }
 
+/*
+ * Satisfy a miss from the most recent fill of @mmu_idx, if that reported
+ * a mapping which covers @addr and allows @type, saving a page table walk
+ * for each further page of a guest huge page.  Unaligned accesses are left
+ * to the target, which may need to raise an exception for them.
+ */
+static bool tlb_fill_from_map(CPUState *cpu, vaddr addr, MMUAccessType type,
+                              int mmu_idx, MemOp memop)
+{
+    CPUTLBDesc *desc = &cpu->neg.tlb.d[mmu_idx];
+    vaddr map_addr = desc->map_fill_addr;
+    CPUTLBEntryFull full;
+    vaddr map_mask;
+
+    if (map_addr == (vaddr)-1) {
+        return false;
+    }
+    map_mask = ~(((vaddr)1 << desc->map_fill.lg_map_size) - 1);
+    if ((addr ^ map_addr) & map_mask) {
+        return false;
+    }
+    if (!(desc->map_fill.prot & (1 << type))) {
+        return false;
+    }
+    if (addr & ((1u << memop_alignment_bits(memop)) - 1)) {
+        return false;
+    }
+
+    full = desc->map_fill;
+    full.phys_addr = (full.phys_addr & TARGET_PAGE_MASK)
+                   + ((addr & TARGET_PAGE_MASK) - (map_addr & TARGET_PAGE_MASK));
+    tlb_set_page_full(cpu, mmu_idx, addr & TARGET_PAGE_MASK, &full);
+    return true;
+}
+
 /*
  * Note: tlb_fill_align() can trigger a resize of the TLB.
  * This means that all of the caller's prior references to the TLB table
@@ -1234,6 +1348,9 @@ static bool tlb_fill_align(CPUState *cpu, vaddr addr, MMUAccessType type,
     const TCGCPUOps *ops = cpu->cc->tcg_ops;
     CPUTLBEntryFull full;
 
+    if (tlb_fill_from_map(cpu, addr, type, mmu_idx, memop)) {
+        return true;
+    }
     if (ops->tlb_fill_align) {
         if (ops->tlb_fill_align(cpu, &full, addr, type, mmu_idx,
                                 memop, size, probe, ra)) {
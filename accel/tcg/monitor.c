@@ -15,10 +15,12 @@
 #include "monitor/monitor.h"
 #include "system/cpus.h"
 #include "system/cpu-timers.h"
+#include "system/stats.h"
 #include "system/tcg.h"
 #include "tcg/tcg.h"
 #include "internal-common.h"
 #include "tb-context.h"
+#include "tb-jmp-cache.h"
 
 
 static void dump_drift_info(GString *buf)
@@ -100,6 +102,7 @@ struct tb_tree_stats {
     size_t max_target_size;
     size_t direct_jmp_count;
     size_t direct_jmp2_count;
+    size_t linked_jmp_count;
     size_t cross_page;
 };
 
@@ -123,22 +126,53 @@ static gboolean tb_tree_stats_iter(gpointer key, gpointer value, gpointer data)
             tst->direct_jmp2_count++;
         }
     }
+    for (int n = 0; n < ARRAY_SIZE(tb->jmp_dest); n++) {
+        /* Bit 0 marks a slot retired by tb_remove_from_jmp_list(). */
+        uintptr_t dest = qatomic_read(&tb->jmp_dest[n]);
+        if (dest && !(dest & 1)) {
+            tst->linked_jmp_count++;
+        }
+    }
     return false;
 }
 
-static void tlb_flush_counts(size_t *pfull, size_t *ppart, size_t *pelide)
+static void tlb_flush_counts(size_t *pfull, size_t *ppart, size_t *pelide,
+                             size_t *pmerged)
 {
     CPUState *cpu;
-    size_t full = 0, part = 0, elide = 0;
+    size_t full = 0, part = 0, elide = 0, merged = 0;
 
     CPU_FOREACH(cpu) {
         full += qatomic_read(&cpu->neg.tlb.c.full_flush_count);
         part += qatomic_read(&cpu->neg.tlb.c.part_flush_count);
         elide += qatomic_read(&cpu->neg.tlb.c.elide_flush_count);
+        merged += qatomic_read(&cpu->neg.tlb.c.merged_flush_count);
     }
     *pfull = full;
     *ppart = part;
     *pelide = elide;
+    *pmerged = merged;
+}
+
+static void jmp_cache_counts(size_t *phits, size_t *pmisses,
+                             size_t *pconflicts)
+{
+    CPUState *cpu;
+    size_t hits = 0, misses = 0, conflicts = 0;
+
+    RCU_READ_LOCK_GUARD();
+    CPU_FOREACH(cpu) {
+        CPUJumpCache *jc = qatomic_rcu_read(&cpu->tb_jmp_cache);
+
+        if (jc) {
+            hits += qatomic_read(&jc->hits);
+            misses += qatomic_read(&jc->misses);
+            conflicts += qatomic_read(&jc->conflicts);
+        }
+    }
+    *phits = hits;
+    *pmisses = misses;
+    *pconflicts = conflicts;
 }
 
 static void tcg_dump_info(GString *buf)
@@ -150,7 +184,9 @@ static void dump_exec_info(GString *buf)
 {
     struct tb_tree_stats tst = {};
     struct qht_stats hst;
-    size_t nb_tbs, flush_full, flush_part, flush_elide;
+    size_t nb_tbs, flush_full, flush_part, flush_elide, flush_merged;
+    size_t jc_hits, jc_misses, jc_conflicts;
+    uint64_t gen_count, gen_time;
 
     tcg_tb_foreach(tb_tree_stats_iter, &tst);
     nb_tbs = tst.nb_tbs;
@@ -181,6 +217,12 @@ static void dump_exec_info(GString *buf)
                            nb_tbs ? (tst.direct_jmp_count * 100) / nb_tbs : 0,
                            tst.direct_jmp2_count,
                            nb_tbs ? (tst.direct_jmp2_count * 100) / nb_tbs : 0);
+    g_string_append_printf(buf, "linked jump count   %zu (%zu%% of direct "
+                           "jump slots)\n",
+                           tst.linked_jmp_count,
+                           tst.direct_jmp_count + tst.direct_jmp2_count ?
+                           (tst.linked_jmp_count * 100) /
+                           (tst.direct_jmp_count + tst.direct_jmp2_count) : 0);
 
     qht_statistics_init(&tb_ctx.htable, &hst);
     print_qht_statistics(hst, buf);
@@ -189,13 +231,33 @@ static void dump_exec_info(GString *buf)
     g_string_append_printf(buf, "\nStatistics:\n");
     g_string_append_printf(buf, "TB flush count      %u\n",
                            qatomic_read(&tb_ctx.tb_flush_count));
+    g_string_append_printf(buf, "TB reclaim count    %u\n",
+                           qatomic_read(&tb_ctx.tb_reclaim_count));
     g_string_append_printf(buf, "TB invalidate count %u\n",
                            qatomic_read(&tb_ctx.tb_phys_invalidate_count));
 
-    tlb_flush_counts(&flush_full, &flush_part, &flush_elide);
+    gen_count = stat64_get(&tb_ctx.tb_gen_count);
+    gen_time = stat64_get(&tb_ctx.tb_gen_time_ns);
+    g_string_append_printf(buf, "TB translate count  %" PRIu64
+                           " (%" PRIu64 " discarded)\n", gen_count,
+                           stat64_get(&tb_ctx.tb_gen_discard_count));
+    g_string_append_printf(buf, "TB translate time   %" PRIu64 " ms "
+                           "(avg %" PRIu64 " ns)\n",
+                           gen_time / SCALE_MS,
+                           gen_count ? gen_time / gen_count : 0);
+
+    tlb_flush_counts(&flush_full, &flush_part, &flush_elide, &flush_merged);
     g_string_append_printf(buf, "TLB full flushes    %zu\n", flush_full);
     g_string_append_printf(buf, "TLB partial flushes %zu\n", flush_part);
     g_string_append_printf(buf, "TLB elided flushes  %zu\n", flush_elide);
+    g_string_append_printf(buf, "TLB merged flushes  %zu\n", flush_merged);
+
+    jmp_cache_counts(&jc_hits, &jc_misses, &jc_conflicts);
+    g_string_append_printf(buf, "TB jmp cache hits   %zu (%zu%%)\n", jc_hits,
+                           jc_hits + jc_misses ?
+                           (jc_hits * 100) / (jc_hits + jc_misses) : 0);
+    g_string_append_printf(buf, "TB jmp cache misses %zu (%zu conflicts)\n",
+                           jc_misses, jc_conflicts);
     tcg_dump_info(buf);
 }
 
@@ -215,11 +277,6 @@ HumanReadableText *qmp_x_query_jit(Error **errp)
     return human_readable_text_from_str(buf);
 }
 
-static void tcg_dump_op_count(GString *buf)
-{
-    g_string_append_printf(buf, "[TCG profiler not compiled]\n");
-}
-
 HumanReadableText *qmp_x_query_opcount(Error **errp)
 {
     g_autoptr(GString) buf = g_string_new("");
@@ -235,10 +292,109 @@ HumanReadableText *qmp_x_query_opcount(Error **errp)
     return human_readable_text_from_str(buf);
 }
 
+static StatsList *tcg_stats_add(StatsList *stats_list, strList *names,
+                                const char *name, uint64_t value)
+{
+    Stats *stats;
+
+    if (!apply_str_list_filter(name, names)) {
+        return stats_list;
+    }
+
+    stats = g_new0(Stats, 1);
+    stats->name = g_strdup(name);
+    stats->value = g_new0(StatsValue, 1);
+    stats->value->type = QTYPE_QNUM;
+    stats->value->u.scalar = value;
+
+    QAPI_LIST_PREPEND(stats_list, stats);
+    return stats_list;
+}
+
+static void tcg_query_stats_vcpu(StatsResultList **result, CPUState *cpu,
+                                 strList *names)
+{
+    CPUJumpCache *jc = qatomic_rcu_read(&cpu->tb_jmp_cache);
+    StatsList *stats_list = NULL;
+
+    if (!jc) {
+        return;
+    }
+
+    stats_list = tcg_stats_add(stats_list, names, "jmp-cache-hits",
+                               qatomic_read(&jc->hits));
+    stats_list = tcg_stats_add(stats_list, names, "jmp-cache-misses",
+                               qatomic_read(&jc->misses));
+    stats_list = tcg_stats_add(stats_list, names, "jmp-cache-conflicts",
+                               qatomic_read(&jc->conflicts));
+    stats_list = tcg_stats_add(stats_list, names, "jmp-cache-resizes",
+                               qatomic_read(&jc->resizes));
+    stats_list = tcg_stats_add(stats_list, names, "jmp-cache-entries",
+                               tb_jmp_cache_size(jc));
+    if (stats_list) {
+        add_stats_entry(result, STATS_PROVIDER_TCG,
+                        cpu->parent_obj.canonical_path, stats_list);
+    }
+}
+
+static void tcg_query_stats_cb(StatsResultList **result, StatsTarget target,
+                               strList *names, strList *targets,
+                               Error **errp)
+{
+    CPUState *cpu;
+
+    if (!tcg_enabled() || target != STATS_TARGET_VCPU) {
+        return;
+    }
+
+    RCU_READ_LOCK_GUARD();
+    CPU_FOREACH(cpu) {
+        if (apply_str_list_filter(cpu->parent_obj.canonical_path, targets)) {
+            tcg_query_stats_vcpu(result, cpu, names);
+        }
+    }
+}
+
+static StatsSchemaValueList *tcg_stats_schema_add(StatsSchemaValueList *list,
+                                                  const char *name,
+                                                  StatsType type)
+{
+    StatsSchemaValue *value = g_new0(StatsSchemaValue, 1);
+
+    value->name = g_strdup(name);
+    value->type = type;
+    QAPI_LIST_PREPEND(list, value);
+    return list;
+}
+
+static void tcg_query_stats_schemas_cb(StatsSchemaList **result, Error **errp)
+{
+    StatsSchemaValueList *stats_list = NULL;
+
+    if (!tcg_enabled()) {
+        return;
+    }
+
+    stats_list = tcg_stats_schema_add(stats_list, "jmp-cache-hits",
+                                      STATS_TYPE_CUMULATIVE);
+    stats_list = tcg_stats_schema_add(stats_list, "jmp-cache-misses",
+                                      STATS_TYPE_CUMULATIVE);
+    stats_list = tcg_stats_schema_add(stats_list, "jmp-cache-conflicts",
+                                      STATS_TYPE_CUMULATIVE);
+    stats_list = tcg_stats_schema_add(stats_list, "jmp-cache-resizes",
+                                      STATS_TYPE_CUMULATIVE);
+    stats_list = tcg_stats_schema_add(stats_list, "jmp-cache-entries",
+                                      STATS_TYPE_INSTANT);
+    add_stats_schema(result, STATS_PROVIDER_TCG, STATS_TARGET_VCPU,
+                     stats_list);
+}
+
 static void hmp_tcg_register(void)
 {
     monitor_register_hmp_info_hrt("jit", qmp_x_query_jit);
     monitor_register_hmp_info_hrt("opcount", qmp_x_query_opcount);
+    add_stats_callbacks(STATS_PROVIDER_TCG, tcg_query_stats_cb,
+                        tcg_query_stats_schemas_cb);
 }
 
 type_init(hmp_tcg_register);
@@ -200,6 +200,38 @@ static void gen_inline_store_u64_cb(struct qemu_plugin_inline_cb *cb)
     tcg_temp_free_ptr(ptr);
 }
 
+static void gen_inline_minmax_u64_cb(struct qemu_plugin_inline_cb *cb,
+                                     bool is_max)
+{
+    TCGv_ptr ptr = gen_plugin_u64_ptr(cb->entry);
+    TCGv_i64 val = tcg_temp_ebb_new_i64();
+    TCGv_i64 imm = tcg_constant_i64(cb->imm);
+
+    tcg_gen_ld_i64(val, ptr, 0);
+    if (is_max) {
+        tcg_gen_umax_i64(val, val, imm);
+    } else {
+        tcg_gen_umin_i64(val, val, imm);
+    }
+    tcg_gen_st_i64(val, ptr, 0);
+
+    tcg_temp_free_i64(val);
+    tcg_temp_free_ptr(ptr);
+}
+
+static void gen_inline_or_u64_cb(struct qemu_plugin_inline_cb *cb)
+{
+    TCGv_ptr ptr = gen_plugin_u64_ptr(cb->entry);
+    TCGv_i64 val = tcg_temp_ebb_new_i64();
+
+    tcg_gen_ld_i64(val, ptr, 0);
+    tcg_gen_ori_i64(val, val, cb->imm);
+    tcg_gen_st_i64(val, ptr, 0);
+
+    tcg_temp_free_i64(val);
+    tcg_temp_free_ptr(ptr);
+}
+
 static void gen_mem_cb(struct qemu_plugin_regular_cb *cb,
                        qemu_plugin_meminfo_t meminfo, TCGv_i64 addr)
 {
@@ -212,6 +244,125 @@ static void gen_mem_cb(struct qemu_plugin_regular_cb *cb,
     tcg_temp_free_i32(cpu_index);
 }
 
+#define MEM_BUFFER_RECORD(field) \
+    offsetof(struct qemu_plugin_mem_buffer_entry, records[0].field)
+
+static void gen_mem_buffer_cb(struct qemu_plugin_mem_buffer_cb *cb,
+                              qemu_plugin_meminfo_t meminfo, TCGv_i64 addr)
+{
+    struct qemu_plugin_mem_buffer *buf = cb->buf;
+    TCGv_ptr ptr = gen_plugin_u64_ptr(qemu_plugin_scoreboard_u64(buf->score));
+    TCGv_ptr rec = tcg_temp_ebb_new_ptr();
+    TCGv_i64 n = tcg_temp_ebb_new_i64();
+    TCGv_i64 off = tcg_temp_ebb_new_i64();
+    TCGv_i64 max = tcg_constant_i64(buf->n_records);
+
+    /*
+     * gen_mem_buffer_reserve made room for this access, but clamp the
+     * index anyway so that a short reservation can never overflow.
+     */
+    tcg_gen_ld_i64(n, ptr, 0);
+    tcg_gen_umin_i64(off, n, tcg_constant_i64(buf->n_records - 1));
+    tcg_gen_muli_i64(off, off, sizeof(qemu_plugin_mem_record));
+    tcg_gen_trunc_i64_ptr(rec, off);
+    tcg_gen_add_ptr(rec, rec, ptr);
+
+    tcg_gen_st_i64(addr, rec, MEM_BUFFER_RECORD(vaddr));
+    tcg_gen_st_i64(tcg_constant_i64(cb->pc), rec, MEM_BUFFER_RECORD(pc));
+    tcg_gen_st_i32(tcg_constant_i32(meminfo), rec, MEM_BUFFER_RECORD(info));
+
+    tcg_gen_addi_i64(n, n, 1);
+    tcg_gen_umin_i64(n, n, max);
+    tcg_gen_st_i64(n, ptr, 0);
+
+    tcg_temp_free_i64(off);
+    tcg_temp_free_i64(n);
+    tcg_temp_free_ptr(rec);
+    tcg_temp_free_ptr(ptr);
+}
+
+/*
+ * Records are appended with plain stores, which cannot drain a full
+ * buffer. Instead, drain it before the instruction if it does not have
+ * room for @need more records.
+ */
+static void gen_mem_buffer_reserve(struct qemu_plugin_mem_buffer_cb *cb,
+                                   size_t need)
+{
+    struct qemu_plugin_mem_buffer *buf = cb->buf;
+    TCGv_ptr ptr = gen_plugin_u64_ptr(qemu_plugin_scoreboard_u64(buf->score));
+    TCGv_i64 n = tcg_temp_ebb_new_i64();
+    TCGLabel *after_cb = gen_new_label();
+
+    tcg_gen_ld_i64(n, ptr, 0);
+    tcg_gen_brcondi_i64(TCG_COND_LEU, n,
+                        buf->n_records - MIN(need, buf->n_records), after_cb);
+    TCGv_i32 cpu_index = gen_cpu_index();
+    tcg_gen_call2(qemu_plugin_mem_buffer_flush_vcpu, cb->info, NULL,
+                  tcgv_i32_temp(cpu_index),
+                  tcgv_ptr_temp(tcg_constant_ptr(buf)));
+    tcg_temp_free_i32(cpu_index);
+    gen_set_label(after_cb);
+
+    tcg_temp_free_i64(n);
+    tcg_temp_free_ptr(ptr);
+}
+
+/* Count the memory accesses of the instruction whose plugin_cb is @op */
+static size_t insn_mem_accesses(TCGOp *op)
+{
+    size_t n = 0;
+
+    while ((op = QTAILQ_NEXT(op, link)) && op->opc != INDEX_op_insn_start) {
+        n += op->opc == INDEX_op_plugin_mem_cb;
+    }
+    return n;
+}
+
+static void gen_mem_buffer_reserve_all(struct qemu_plugin_insn *insn,
+                                       TCGOp *op)
+{
+    const GArray *cbs = insn->mem_cbs;
+    size_t n_mem = 0;
+    int i, j, n;
+
+    for (i = 0, n = (cbs ? cbs->len : 0); i < n; i++) {
+        struct qemu_plugin_dyn_cb *cb =
+            &g_array_index(cbs, struct qemu_plugin_dyn_cb, i);
+        size_t uses = 0;
+
+        if (cb->type != PLUGIN_CB_MEM_BUFFER) {
+            continue;
+        }
+
+        /* reserve once per buffer, for all of its registrations */
+        for (j = 0; j < n; j++) {
+            struct qemu_plugin_dyn_cb *other =
+                &g_array_index(cbs, struct qemu_plugin_dyn_cb, j);
+
+            if (other->type == PLUGIN_CB_MEM_BUFFER &&
+                other->mem_buffer.buf == cb->mem_buffer.buf) {
+                if (j < i) {
+                    break;
+                }
+                uses++;
+            }
+        }
+        if (!uses) {
+            continue;
+        }
+
+        if (!n_mem) {
+            n_mem = insn_mem_accesses(op);
+            if (!n_mem) {
+                /* accesses from helpers drain the buffer themselves */
+                return;
+            }
+        }
+        gen_mem_buffer_reserve(&cb->mem_buffer, n_mem * uses);
+    }
+}
+
 static void inject_cb(struct qemu_plugin_dyn_cb *cb)
 
 {
@@ -228,6 +379,15 @@ static void inject_cb(struct qemu_plugin_dyn_cb *cb)
     case PLUGIN_CB_INLINE_STORE_U64:
         gen_inline_store_u64_cb(&cb->inline_insn);
         break;
+    case PLUGIN_CB_INLINE_MIN_U64:
+        gen_inline_minmax_u64_cb(&cb->inline_insn, false);
+        break;
+    case PLUGIN_CB_INLINE_MAX_U64:
+        gen_inline_minmax_u64_cb(&cb->inline_insn, true);
+        break;
+    case PLUGIN_CB_INLINE_OR_U64:
+        gen_inline_or_u64_cb(&cb->inline_insn);
+        break;
     default:
         g_assert_not_reached();
     }
@@ -245,10 +405,18 @@ static void inject_mem_cb(struct qemu_plugin_dyn_cb *cb,
         break;
     case PLUGIN_CB_INLINE_ADD_U64:
     case PLUGIN_CB_INLINE_STORE_U64:
+    case PLUGIN_CB_INLINE_MIN_U64:
+    case PLUGIN_CB_INLINE_MAX_U64:
+    case PLUGIN_CB_INLINE_OR_U64:
         if (rw & cb->inline_insn.rw) {
             inject_cb(cb);
         }
         break;
+    case PLUGIN_CB_MEM_BUFFER:
+        if (rw & cb->mem_buffer.rw) {
+            gen_mem_buffer_cb(&cb->mem_buffer, meminfo, addr);
+        }
+        break;
     default:
         g_assert_not_reached();
     }
@@ -324,6 +492,7 @@ static void plugin_gen_inject(struct qemu_plugin_tb *plugin_tb)
                 assert(insn != NULL);
 
                 gen_enable_mem_helper(plugin_tb, insn);
+                gen_mem_buffer_reserve_all(insn, op);
 
                 cbs = insn->insn_cbs;
                 for (i = 0, n = (cbs ? cbs->len : 0); i < n; i++) {
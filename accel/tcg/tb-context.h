@@ -22,6 +22,7 @@
 
 #include "qemu/thread.h"
 #include "qemu/qht.h"
+#include "qemu/stats64.h"
 
 #define CODE_GEN_HTABLE_BITS     15
 #define CODE_GEN_HTABLE_SIZE     (1 << CODE_GEN_HTABLE_BITS)
@@ -34,7 +35,13 @@ struct TBContext {
 
     /* statistics */
     unsigned tb_flush_count;
+    unsigned tb_reclaim_count;
     unsigned tb_phys_invalidate_count;
+    Stat64 tb_gen_count;
+    Stat64 tb_gen_discard_count;
+    Stat64 tb_gen_time_ns;
+    Stat64 tb_gen_insn_count;
+    Stat64 tb_gen_code_size;
 };
 
 extern TBContext tb_ctx;
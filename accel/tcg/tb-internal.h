@@ -50,4 +50,13 @@ bool tb_invalidate_phys_page_unwind(tb_page_addr_t addr, uintptr_t pc);
 
 void tb_check_watchpoint(CPUState *cpu, uintptr_t retaddr);
 
+/**
+ * tb_reclaim:
+ * @cpu: the CPU that ran out of space for translations
+ *
+ * Make room in the code buffer by invalidating the oldest translations,
+ * falling back to tb_flush() if that is not possible.
+ */
+void tb_reclaim(CPUState *cpu);
+
 #endif
@@ -12,8 +12,14 @@
 #include "qemu/rcu.h"
 #include "exec/cpu-common.h"
 
+/*
+ * The cache starts at TB_JMP_CACHE_BITS and is resized by its owning
+ * vCPU between TB_JMP_CACHE_MIN_BITS and TB_JMP_CACHE_MAX_BITS, based
+ * on the hit/conflict rate seen over a window of misses.
+ */
 #define TB_JMP_CACHE_BITS 12
-#define TB_JMP_CACHE_SIZE (1 << TB_JMP_CACHE_BITS)
+#define TB_JMP_CACHE_MIN_BITS 8
+#define TB_JMP_CACHE_MAX_BITS 16
 
 /*
  * Invalidated in parallel; all accesses to 'tb' must be atomic.
@@ -21,13 +27,33 @@
  * no need for qatomic_rcu_read() and pc is always consistent with a
  * non-NULL value of 'tb'.  Strictly speaking pc is only needed for
  * CF_PCREL, but it's used always for simplicity.
+ *
+ * The cache itself may be replaced by its owning CPU when resized;
+ * other CPUs must access it within an RCU read-side critical section.
+ * The statistics are only written by the owning CPU.
  */
 typedef struct CPUJumpCache {
     struct rcu_head rcu;
+    unsigned bits;
+    size_t hits;
+    size_t misses;
+    size_t conflicts;
+    size_t resizes;
+    /* Counter values at the start of the current resize window. */
+    size_t window_hits;
+    size_t window_misses;
+    size_t window_conflicts;
     struct {
         TranslationBlock *tb;
         vaddr pc;
-    } array[TB_JMP_CACHE_SIZE];
+    } array[];
 } CPUJumpCache;
 
+static inline size_t tb_jmp_cache_size(const CPUJumpCache *jc)
+{
+    return (size_t)1 << jc->bits;
+}
+
+CPUJumpCache *tb_jmp_cache_new(unsigned bits);
+
 #endif /* ACCEL_TCG_TB_JMP_CACHE_H */
@@ -889,10 +889,11 @@ static void tb_jmp_cache_inval_tb(TranslationBlock *tb)
             tcg_flush_jmp_cache(cpu);
         }
     } else {
-        uint32_t h = tb_jmp_cache_hash_func(tb->pc);
+        RCU_READ_LOCK_GUARD();
 
         CPU_FOREACH(cpu) {
-            CPUJumpCache *jc = cpu->tb_jmp_cache;
+            CPUJumpCache *jc = qatomic_rcu_read(&cpu->tb_jmp_cache);
+            uint32_t h = tb_jmp_cache_hash_func(jc, tb->pc);
 
             if (qatomic_read(&jc->array[h].tb) == tb) {
                 qatomic_set(&jc->array[h].tb, NULL);
@@ -905,8 +906,11 @@ static void tb_jmp_cache_inval_tb(TranslationBlock *tb)
  * In user-mode, call with mmap_lock held.
  * In !user-mode, if @rm_from_page_list is set, call with the TB's pages'
  * locks held.
+ * @rm_from_jmp_cache may be false only if all jump caches have been, or
+ * are about to be, flushed.
  */
-static void do_tb_phys_invalidate(TranslationBlock *tb, bool rm_from_page_list)
+static void do_tb_phys_invalidate(TranslationBlock *tb, bool rm_from_page_list,
+                                  bool rm_from_jmp_cache)
 {
     uint32_t h;
     tb_page_addr_t phys_pc;
@@ -933,7 +937,9 @@ static void do_tb_phys_invalidate(TranslationBlock *tb, bool rm_from_page_list)
     }
 
     /* remove the TB from the hash list */
-    tb_jmp_cache_inval_tb(tb);
+    if (rm_from_jmp_cache) {
+        tb_jmp_cache_inval_tb(tb);
+    }
 
     /* suppress this TB from the two jump lists */
     tb_remove_from_jmp_list(tb, 0);
@@ -949,7 +955,7 @@ static void do_tb_phys_invalidate(TranslationBlock *tb, bool rm_from_page_list)
 static void tb_phys_invalidate__locked(TranslationBlock *tb)
 {
     qemu_thread_jit_write();
-    do_tb_phys_invalidate(tb, true);
+    do_tb_phys_invalidate(tb, true, true);
     qemu_thread_jit_execute();
 }
 
@@ -961,10 +967,83 @@ void tb_phys_invalidate(TranslationBlock *tb, tb_page_addr_t page_addr)
 {
     if (page_addr == -1 && tb_page_addr0(tb) != -1) {
         tb_lock_pages(tb);
-        do_tb_phys_invalidate(tb, true);
+        do_tb_phys_invalidate(tb, true, true);
         tb_unlock_pages(tb);
     } else {
-        do_tb_phys_invalidate(tb, false);
+        do_tb_phys_invalidate(tb, false, true);
+    }
+}
+
+/*
+ * Called from tcg_region_evict, in a safe-work context after all
+ * jump caches have been flushed.
+ */
+static void tb_evict(TranslationBlock *tb)
+{
+    tb_lock_pages(tb);
+    do_tb_phys_invalidate(tb, true, false);
+    tb_unlock_pages(tb);
+}
+
+/*
+ * Plugins keep per-TB data that is only released by a full flush, and
+ * expect qemu_plugin_flush_cb to tell them when translations go away.
+ */
+static bool tb_reclaim_allowed(CPUState *cpu)
+{
+#ifdef CONFIG_PLUGIN
+    if (cpu->plugin_state &&
+        test_bit(QEMU_PLUGIN_EV_VCPU_TB_TRANS, cpu->plugin_state->event_mask)) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+/* recycle the oldest translations, or flush them all if that fails */
+static void do_tb_reclaim(CPUState *cpu, run_on_cpu_data tb_reclaim_gen)
+{
+    CPUState *c;
+    bool did_reclaim = false;
+
+    mmap_lock();
+    /* If space has already been made on request of another CPU, just retry. */
+    if (tb_ctx.tb_flush_count + tb_ctx.tb_reclaim_count !=
+        tb_reclaim_gen.host_int) {
+        mmap_unlock();
+        return;
+    }
+
+    if (tb_reclaim_allowed(cpu)) {
+        CPU_FOREACH(c) {
+            tcg_flush_jmp_cache(c);
+        }
+        qemu_thread_jit_write();
+        did_reclaim = tcg_region_evict(tb_evict);
+        qemu_thread_jit_execute();
+        if (did_reclaim) {
+            qatomic_inc(&tb_ctx.tb_reclaim_count);
+        }
+    }
+    mmap_unlock();
+
+    if (!did_reclaim) {
+        do_tb_flush(cpu, RUN_ON_CPU_HOST_INT(tb_ctx.tb_flush_count));
+    }
+}
+
+void tb_reclaim(CPUState *cpu)
+{
+    if (tcg_enabled()) {
+        unsigned gen = qatomic_read(&tb_ctx.tb_flush_count) +
+                       qatomic_read(&tb_ctx.tb_reclaim_count);
+
+        if (cpu_in_serial_context(cpu)) {
+            do_tb_reclaim(cpu, RUN_ON_CPU_HOST_INT(gen));
+        } else {
+            async_safe_run_on_cpu(cpu, do_tb_reclaim,
+                                  RUN_ON_CPU_HOST_INT(gen));
+        }
     }
 }
 
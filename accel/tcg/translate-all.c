@@ -285,6 +285,23 @@ static int setjmp_gen_code(CPUArchState *env, TranslationBlock *tb,
     return tcg_gen_code(tcg_ctx, tb, pc);
 }
 
+/*
+ * Account for the cost of one call to tb_gen_code, started at TI,
+ * which produced TB.  DISCARD is true if the result lost the race to
+ * another vCPU translating the same block.
+ */
+static void tb_gen_code_account(int64_t ti, TranslationBlock *tb,
+                                bool discard)
+{
+    stat64_add(&tb_ctx.tb_gen_count, 1);
+    stat64_add(&tb_ctx.tb_gen_time_ns, get_clock() - ti);
+    stat64_add(&tb_ctx.tb_gen_insn_count, tb->icount);
+    stat64_add(&tb_ctx.tb_gen_code_size, tb->tc.size);
+    if (discard) {
+        stat64_add(&tb_ctx.tb_gen_discard_count, 1);
+    }
+}
+
 /* Called with mmap_lock held for user mode emulation.  */
 TranslationBlock *tb_gen_code(CPUState *cpu,
                               vaddr pc, uint64_t cs_base,
@@ -300,6 +317,7 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
 
     assert_memory_lock();
     qemu_thread_jit_write();
+    ti = get_clock();
 
     phys_pc = get_page_addr_code_hostp(env, pc, &host_pc);
 
@@ -318,8 +336,8 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
     assert_no_pages_locked();
     tb = tcg_tb_alloc(tcg_ctx);
     if (unlikely(!tb)) {
-        /* flush must be done */
-        tb_flush(cpu);
+        /* reclaim must be done */
+        tb_reclaim(cpu);
         mmap_unlock();
         /* Make the execution loop process the flush as soon as possible.  */
         cpu->exception_index = EXCP_INTERRUPT;
@@ -353,6 +371,16 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
 #else
     tcg_ctx->guest_mo = TCG_MO_ALL;
 #endif
+    /*
+     * Blocks not backed by RAM are discarded after a single execution.
+     * Blocks requested via cflags_next_tb with CF_NOIRQ or CF_MEMI_ONLY
+     * exist to replay one instruction after a watchpoint, icount I/O or
+     * self-modifying code event, and are rarely looked up again.
+     * The optimizer still runs for them if it has mandatory lowering
+     * to do; see tcg_gen_code.
+     */
+    tcg_ctx->skip_optimize = phys_pc == -1 ||
+                             (cflags & (CF_NOIRQ | CF_MEMI_ONLY));
 
  restart_translate:
     trace_translate_block(tb, pc, tb->tc.ptr);
@@ -536,6 +564,7 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
      */
     if (tb_page_addr0(tb) == -1) {
         assert_no_pages_locked();
+        tb_gen_code_account(ti, tb, false);
         return tb;
     }
 
@@ -560,11 +589,30 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
         orig_aligned -= ROUND_UP(sizeof(*tb), qemu_icache_linesize);
         qatomic_set(&tcg_ctx->code_gen_ptr, (void *)orig_aligned);
         tcg_tb_remove(tb);
+        tb_gen_code_account(ti, tb, true);
         return existing_tb;
     }
+    tb_gen_code_account(ti, tb, false);
     return tb;
 }
 
+void tb_dump_stats(GString *buf)
+{
+    g_string_append_printf(buf, "translations        %" PRIu64 "\n",
+                           stat64_get(&tb_ctx.tb_gen_count));
+    g_string_append_printf(buf, "translations lost   %" PRIu64 "\n",
+                           stat64_get(&tb_ctx.tb_gen_discard_count));
+    g_string_append_printf(buf, "translation time    %" PRIu64 " ns\n",
+                           stat64_get(&tb_ctx.tb_gen_time_ns));
+    g_string_append_printf(buf, "guest insns         %" PRIu64 "\n",
+                           stat64_get(&tb_ctx.tb_gen_insn_count));
+    g_string_append_printf(buf, "host code bytes     %" PRIu64 "\n",
+                           stat64_get(&tb_ctx.tb_gen_code_size));
+    g_string_append_printf(buf, "flushes             %u\n",
+                           qatomic_read(&tb_ctx.tb_flush_count));
+    tcg_dump_op_count(buf);
+}
+
 /* user-mode: call with mmap_lock held */
 void tb_check_watchpoint(CPUState *cpu, uintptr_t retaddr)
 {
@@ -654,14 +702,19 @@ void cpu_io_recompile(CPUState *cpu, uintptr_t retaddr)
  */
 void tcg_flush_jmp_cache(CPUState *cpu)
 {
-    CPUJumpCache *jc = cpu->tb_jmp_cache;
+    CPUJumpCache *jc;
+    size_t size;
+
+    RCU_READ_LOCK_GUARD();
+    jc = qatomic_rcu_read(&cpu->tb_jmp_cache);
 
     /* During early initialization, the cache may not yet be allocated. */
     if (unlikely(jc == NULL)) {
         return;
     }
 
-    for (int i = 0; i < TB_JMP_CACHE_SIZE; i++) {
+    size = tb_jmp_cache_size(jc);
+    for (size_t i = 0; i < size; i++) {
         qatomic_set(&jc->array[i].tb, NULL);
     }
 }
@@ -691,6 +691,22 @@ void page_protect(tb_page_addr_t address)
     }
 }
 
+/*
+ * A subroutine of page_unprotect: the page is already writable, because
+ * this thread raced with another one which got there first and did the
+ * TB invalidate for us.  Return true if the current TB was invalidated.
+ */
+static bool page_unprotect_raced(uintptr_t pc)
+{
+#ifdef TARGET_HAS_PRECISE_SMC
+    TranslationBlock *current_tb = tcg_tb_lookup(pc);
+    if (current_tb) {
+        return tb_cflags(current_tb) & CF_INVALID;
+    }
+#endif
+    return false;
+}
+
 /*
  * Called from signal handler: invalidate the code and unprotect the
  * page. Return 0 if the fault was not handled, 1 if it was handled,
@@ -703,6 +719,19 @@ int page_unprotect(tb_page_addr_t address, uintptr_t pc)
     PageFlagsNode *p;
     bool current_tb_invalidated;
 
+    /*
+     * When many threads write to the same freshly translated page, all
+     * but the first find it already writable.  Lockless lookups have no
+     * false positives, so let those return without taking the mmap lock.
+     * If the flags are stale, the access simply faults again.
+     */
+    WITH_RCU_READ_LOCK_GUARD() {
+        p = pageflags_find(address, address);
+        if (p && (p->flags & PAGE_WRITE)) {
+            return page_unprotect_raced(pc) ? 2 : 1;
+        }
+    }
+
     /*
      * Technically this isn't safe inside a signal handler.  However we
      * know this only ever happens in a synchronous SEGV handler, so in
@@ -720,17 +749,8 @@ int page_unprotect(tb_page_addr_t address, uintptr_t pc)
 
     current_tb_invalidated = false;
     if (p->flags & PAGE_WRITE) {
-        /*
-         * If the page is actually marked WRITE then assume this is because
-         * this thread raced with another one which got here first and
-         * set the page to PAGE_WRITE and did the TB invalidate for us.
-         */
-#ifdef TARGET_HAS_PRECISE_SMC
-        TranslationBlock *current_tb = tcg_tb_lookup(pc);
-        if (current_tb) {
-            current_tb_invalidated = tb_cflags(current_tb) & CF_INVALID;
-        }
-#endif
+        /* Lost the race since the lockless lookup above. */
+        current_tb_invalidated = page_unprotect_raced(pc);
     } else {
         int host_page_size = qemu_real_host_page_size();
         target_ulong start, len, i;
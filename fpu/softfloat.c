@@ -241,6 +241,26 @@ static inline bool can_use_fpu(const float_status *s)
                   s->float_rounding_mode == float_round_nearest_even);
 }
 
+/*
+ * Operations that can tell cheaply whether the host result is exact do not
+ * need the inexact flag to be set already; they raise it themselves.  This
+ * matters for targets that clear the flags before each instruction.
+ * Excess precision (e.g. x87) would make the exactness tests unreliable.
+ */
+#if FLT_EVAL_METHOD == 0
+# define QEMU_HARDFLOAT_EXACT_TEST 1
+#else
+# define QEMU_HARDFLOAT_EXACT_TEST 0
+#endif
+
+static inline bool can_use_fpu_rounding(const float_status *s)
+{
+    if (QEMU_NO_HARDFLOAT || !QEMU_HARDFLOAT_EXACT_TEST) {
+        return false;
+    }
+    return likely(s->float_rounding_mode == float_round_nearest_even);
+}
+
 /*
  * Hardfloat generation functions. Each operation can have two flavors:
  * either using softfloat primitives (e.g. float32_is_zero_or_normal) for
@@ -265,6 +285,10 @@ typedef union {
 
 typedef bool (*f32_check_fn)(union_float32 a, union_float32 b);
 typedef bool (*f64_check_fn)(union_float64 a, union_float64 b);
+typedef bool (*f32_exact_fn)(union_float32 a, union_float32 b,
+                             union_float32 r);
+typedef bool (*f64_exact_fn)(union_float64 a, union_float64 b,
+                             union_float64 r);
 
 typedef float32 (*soft_f32_op2_fn)(float32 a, float32 b, float_status *s);
 typedef float64 (*soft_f64_op2_fn)(float64 a, float64 b, float_status *s);
@@ -342,15 +366,19 @@ static inline bool f64_is_inf(union_float64 a)
 static inline float32
 float32_gen2(float32 xa, float32 xb, float_status *s,
              hard_f32_op2_fn hard, soft_f32_op2_fn soft,
-             f32_check_fn pre, f32_check_fn post)
+             f32_check_fn pre, f32_check_fn post, f32_exact_fn exact)
 {
     union_float32 ua, ub, ur;
+    bool test_exact = false;
 
     ua.s = xa;
     ub.s = xb;
 
     if (unlikely(!can_use_fpu(s))) {
-        goto soft;
+        if (!exact || !can_use_fpu_rounding(s)) {
+            goto soft;
+        }
+        test_exact = true;
     }
 
     float32_input_flush2(&ua.s, &ub.s, s);
@@ -360,9 +388,14 @@ float32_gen2(float32 xa, float32 xb, float_status *s,
 
     ur.h = hard(ua.h, ub.h);
     if (unlikely(f32_is_inf(ur))) {
+        if (test_exact) {
+            goto soft;
+        }
         float_raise(float_flag_overflow, s);
     } else if (unlikely(fabsf(ur.h) <= FLT_MIN) && post(ua, ub)) {
         goto soft;
+    } else if (test_exact && !exact(ua, ub, ur)) {
+        float_raise(float_flag_inexact, s);
     }
     return ur.s;
 
@@ -373,15 +406,19 @@ float32_gen2(float32 xa, float32 xb, float_status *s,
 static inline float64
 float64_gen2(float64 xa, float64 xb, float_status *s,
              hard_f64_op2_fn hard, soft_f64_op2_fn soft,
-             f64_check_fn pre, f64_check_fn post)
+             f64_check_fn pre, f64_check_fn post, f64_exact_fn exact)
 {
     union_float64 ua, ub, ur;
+    bool test_exact = false;
 
     ua.s = xa;
     ub.s = xb;
 
     if (unlikely(!can_use_fpu(s))) {
-        goto soft;
+        if (!exact || !can_use_fpu_rounding(s)) {
+            goto soft;
+        }
+        test_exact = true;
     }
 
     float64_input_flush2(&ua.s, &ub.s, s);
@@ -391,9 +428,14 @@ float64_gen2(float64 xa, float64 xb, float_status *s,
 
     ur.h = hard(ua.h, ub.h);
     if (unlikely(f64_is_inf(ur))) {
+        if (test_exact) {
+            goto soft;
+        }
         float_raise(float_flag_overflow, s);
     } else if (unlikely(fabs(ur.h) <= DBL_MIN) && post(ua, ub)) {
         goto soft;
+    } else if (test_exact && !exact(ua, ub, ur)) {
+        float_raise(float_flag_inexact, s);
     }
     return ur.s;
 
@@ -401,6 +443,89 @@ float64_gen2(float64 xa, float64 xb, float_status *s,
     return soft(ua.s, ub.s, s);
 }
 
+/*
+ * Batched variants of the above, for vector helpers: the checks that
+ * only depend on @s are done once per call, and lanes are processed in
+ * chunks whose hardfloat results are computed with no per-lane branch.
+ * If any lane of a chunk needs an exception flag other than inexact
+ * (which can_use_fpu requires to be set already), or a zero or denormal
+ * result, the whole chunk is redone lane by lane with the scalar code.
+ * This computes bit-identical results and flags to the scalar code.
+ */
+#define HARDFLOAT_CHUNK 16
+
+static inline void
+float32_gen2_n(float32 *d, const float32 *a, const float32 *b, size_t n,
+               float_status *s, hard_f32_op2_fn hard, soft_f32_op2_fn soft,
+               f32_check_fn pre, f32_check_fn post, f32_exact_fn exact)
+{
+    size_t i, j, len;
+
+    for (i = 0; i < n; i += len) {
+        len = MIN(n - i, HARDFLOAT_CHUNK);
+
+        if (likely(can_use_fpu(s))) {
+            union_float32 r[HARDFLOAT_CHUNK];
+            bool ok = true;
+
+            for (j = 0; j < len; j++) {
+                union_float32 ua = { .s = a[i + j] }, ub = { .s = b[i + j] };
+
+                r[j].h = hard(ua.h, ub.h);
+                ok &= float32_is_zero_or_normal(ua.s) &&
+                      float32_is_zero_or_normal(ub.s) &&
+                      !f32_is_inf(r[j]) && fabsf(r[j].h) > FLT_MIN;
+            }
+            if (likely(ok)) {
+                for (j = 0; j < len; j++) {
+                    d[i + j] = r[j].s;
+                }
+                continue;
+            }
+        }
+        for (j = 0; j < len; j++) {
+            d[i + j] = float32_gen2(a[i + j], b[i + j], s,
+                                    hard, soft, pre, post, exact);
+        }
+    }
+}
+
+static inline void
+float64_gen2_n(float64 *d, const float64 *a, const float64 *b, size_t n,
+               float_status *s, hard_f64_op2_fn hard, soft_f64_op2_fn soft,
+               f64_check_fn pre, f64_check_fn post, f64_exact_fn exact)
+{
+    size_t i, j, len;
+
+    for (i = 0; i < n; i += len) {
+        len = MIN(n - i, HARDFLOAT_CHUNK);
+
+        if (likely(can_use_fpu(s))) {
+            union_float64 r[HARDFLOAT_CHUNK];
+            bool ok = true;
+
+            for (j = 0; j < len; j++) {
+                union_float64 ua = { .s = a[i + j] }, ub = { .s = b[i + j] };
+
+                r[j].h = hard(ua.h, ub.h);
+                ok &= float64_is_zero_or_normal(ua.s) &&
+                      float64_is_zero_or_normal(ub.s) &&
+                      !f64_is_inf(r[j]) && fabs(r[j].h) > DBL_MIN;
+            }
+            if (likely(ok)) {
+                for (j = 0; j < len; j++) {
+                    d[i + j] = r[j].s;
+                }
+                continue;
+            }
+        }
+        for (j = 0; j < len; j++) {
+            d[i + j] = float64_gen2(a[i + j], b[i + j], s,
+                                    hard, soft, pre, post, exact);
+        }
+    }
+}
+
 /*
  * Classify a floating point number. Everything above float_class_qnan
  * is a NaN so cls >= float_class_qnan is any NaN.
@@ -1968,42 +2093,114 @@ static bool f64_addsubmul_post(union_float64 a, union_float64 b)
     }
 }
 
+/*
+ * Fast2Sum: with round-to-nearest and |big| >= |small|, the rounding
+ * error of big + small is exactly small - (r - big).
+ */
+static bool f32_add_exact(union_float32 a, union_float32 b, union_float32 r)
+{
+    bool a_big = fabsf(a.h) >= fabsf(b.h);
+    float big = a_big ? a.h : b.h;
+    float small = a_big ? b.h : a.h;
+
+    return small - (r.h - big) == 0;
+}
+
+static bool f32_sub_exact(union_float32 a, union_float32 b, union_float32 r)
+{
+    b.h = -b.h;
+    return f32_add_exact(a, b, r);
+}
+
+static bool f64_add_exact(union_float64 a, union_float64 b, union_float64 r)
+{
+    bool a_big = fabs(a.h) >= fabs(b.h);
+    double big = a_big ? a.h : b.h;
+    double small = a_big ? b.h : a.h;
+
+    return small - (r.h - big) == 0;
+}
+
+static bool f64_sub_exact(union_float64 a, union_float64 b, union_float64 r)
+{
+    b.h = -b.h;
+    return f64_add_exact(a, b, r);
+}
+
 static float32 float32_addsub(float32 a, float32 b, float_status *s,
-                              hard_f32_op2_fn hard, soft_f32_op2_fn soft)
+                              hard_f32_op2_fn hard, soft_f32_op2_fn soft,
+                              f32_exact_fn exact)
 {
     return float32_gen2(a, b, s, hard, soft,
-                        f32_is_zon2, f32_addsubmul_post);
+                        f32_is_zon2, f32_addsubmul_post, exact);
 }
 
 static float64 float64_addsub(float64 a, float64 b, float_status *s,
-                              hard_f64_op2_fn hard, soft_f64_op2_fn soft)
+                              hard_f64_op2_fn hard, soft_f64_op2_fn soft,
+                              f64_exact_fn exact)
 {
     return float64_gen2(a, b, s, hard, soft,
-                        f64_is_zon2, f64_addsubmul_post);
+                        f64_is_zon2, f64_addsubmul_post, exact);
 }
 
 float32 QEMU_FLATTEN
 float32_add(float32 a, float32 b, float_status *s)
 {
-    return float32_addsub(a, b, s, hard_f32_add, soft_f32_add);
+    return float32_addsub(a, b, s, hard_f32_add, soft_f32_add,
+                          f32_add_exact);
 }
 
 float32 QEMU_FLATTEN
 float32_sub(float32 a, float32 b, float_status *s)
 {
-    return float32_addsub(a, b, s, hard_f32_sub, soft_f32_sub);
+    return float32_addsub(a, b, s, hard_f32_sub, soft_f32_sub,
+                          f32_sub_exact);
 }
 
 float64 QEMU_FLATTEN
 float64_add(float64 a, float64 b, float_status *s)
 {
-    return float64_addsub(a, b, s, hard_f64_add, soft_f64_add);
+    return float64_addsub(a, b, s, hard_f64_add, soft_f64_add,
+                          f64_add_exact);
 }
 
 float64 QEMU_FLATTEN
 float64_sub(float64 a, float64 b, float_status *s)
 {
-    return float64_addsub(a, b, s, hard_f64_sub, soft_f64_sub);
+    return float64_addsub(a, b, s, hard_f64_sub, soft_f64_sub,
+                          f64_sub_exact);
+}
+
+void QEMU_FLATTEN
+float32_add_n(float32 *d, const float32 *a, const float32 *b, size_t n,
+              float_status *s)
+{
+    float32_gen2_n(d, a, b, n, s, hard_f32_add, soft_f32_add,
+                   f32_is_zon2, f32_addsubmul_post, f32_add_exact);
+}
+
+void QEMU_FLATTEN
+float32_sub_n(float32 *d, const float32 *a, const float32 *b, size_t n,
+              float_status *s)
+{
+    float32_gen2_n(d, a, b, n, s, hard_f32_sub, soft_f32_sub,
+                   f32_is_zon2, f32_addsubmul_post, f32_sub_exact);
+}
+
+void QEMU_FLATTEN
+float64_add_n(float64 *d, const float64 *a, const float64 *b, size_t n,
+              float_status *s)
+{
+    float64_gen2_n(d, a, b, n, s, hard_f64_add, soft_f64_add,
+                   f64_is_zon2, f64_addsubmul_post, f64_add_exact);
+}
+
+void QEMU_FLATTEN
+float64_sub_n(float64 *d, const float64 *a, const float64 *b, size_t n,
+              float_status *s)
+{
+    float64_gen2_n(d, a, b, n, s, hard_f64_sub, soft_f64_sub,
+                   f64_is_zon2, f64_addsubmul_post, f64_sub_exact);
 }
 
 static float64 float64r32_addsub(float64 a, float64 b, float_status *status,
@@ -2145,18 +2342,44 @@ static double hard_f64_mul(double a, double b)
     return a * b;
 }
 
+/*
+ * The product of two floats is exact as a double.  There is no such
+ * cheap test for float64, whose multiplications keep needing the inexact
+ * flag to be set to use the host FPU.
+ */
+static bool f32_mul_exact(union_float32 a, union_float32 b, union_float32 r)
+{
+    return (double)a.h * (double)b.h == (double)r.h;
+}
+
 float32 QEMU_FLATTEN
 float32_mul(float32 a, float32 b, float_status *s)
 {
     return float32_gen2(a, b, s, hard_f32_mul, soft_f32_mul,
-                        f32_is_zon2, f32_addsubmul_post);
+                        f32_is_zon2, f32_addsubmul_post, f32_mul_exact);
 }
 
 float64 QEMU_FLATTEN
 float64_mul(float64 a, float64 b, float_status *s)
 {
     return float64_gen2(a, b, s, hard_f64_mul, soft_f64_mul,
-                        f64_is_zon2, f64_addsubmul_post);
+                        f64_is_zon2, f64_addsubmul_post, NULL);
+}
+
+void QEMU_FLATTEN
+float32_mul_n(float32 *d, const float32 *a, const float32 *b, size_t n,
+              float_status *s)
+{
+    float32_gen2_n(d, a, b, n, s, hard_f32_mul, soft_f32_mul,
+                   f32_is_zon2, f32_addsubmul_post, f32_mul_exact);
+}
+
+void QEMU_FLATTEN
+float64_mul_n(float64 *d, const float64 *a, const float64 *b, size_t n,
+              float_status *s)
+{
+    float64_gen2_n(d, a, b, n, s, hard_f64_mul, soft_f64_mul,
+                   f64_is_zon2, f64_addsubmul_post, NULL);
 }
 
 float64 float64r32_mul(float64 a, float64 b, float_status *status)
@@ -2523,14 +2746,14 @@ float32 QEMU_FLATTEN
 float32_div(float32 a, float32 b, float_status *s)
 {
     return float32_gen2(a, b, s, hard_f32_div, soft_f32_div,
-                        f32_div_pre, f32_div_post);
+                        f32_div_pre, f32_div_post, NULL);
 }
 
 float64 QEMU_FLATTEN
 float64_div(float64 a, float64 b, float_status *s)
 {
     return float64_gen2(a, b, s, hard_f64_div, soft_f64_div,
-                        f64_div_pre, f64_div_post);
+                        f64_div_pre, f64_div_post, NULL);
 }
 
 float64 float64r32_div(float64 a, float64 b, float_status *status)
@@ -183,7 +183,8 @@ void tlb_flush_range_by_mmuidx_all_cpus_synced(CPUState *cpu,
  *
  * At most one entry for a given virtual address is permitted. Only a
  * single TARGET_PAGE_SIZE region is mapped; @full->lg_page_size is only
- * used by tlb_flush_page.
+ * used by tlb_flush_page.  If @full->lg_map_size is set, later misses
+ * within that mapping may be filled from @full without calling tlb_fill.
  */
 void tlb_set_page_full(CPUState *cpu, int mmu_idx, vaddr addr,
                        CPUTLBEntryFull *full);
@@ -433,6 +434,15 @@ void tb_phys_invalidate(TranslationBlock *tb, tb_page_addr_t page_addr);
 void tb_invalidate_phys_range(tb_page_addr_t start, tb_page_addr_t last);
 void tb_set_jmp_target(TranslationBlock *tb, int n, uintptr_t addr);
 
+/**
+ * tb_dump_stats:
+ * @buf: buffer to append to
+ *
+ * Append the translation statistics gathered so far to @buf, one
+ * name and value per line, for consumption by benchmark scripts.
+ */
+void tb_dump_stats(GString *buf);
+
 /* GETPC is the true target of the return instruction that we'll execute.  */
 #if defined(CONFIG_TCG_INTERPRETER)
 extern __thread uintptr_t tci_tb_ptr;
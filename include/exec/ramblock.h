@@ -80,6 +80,15 @@ struct RAMBlock {
     unsigned long *clear_bmap;
     uint8_t clear_bmap_shift;
 
+    /*
+     * Number of successive dirty bitmap syncs that found each chunk of
+     * 1 << hotness_shift pages dirty.  Only allocated on the source side
+     * when the defer-hot-pages capability is set, and protected by the
+     * global ram_state.bitmap_mutex like clear_bmap.
+     */
+    uint8_t *hotness;
+    uint8_t hotness_shift;
+
     /*
      * RAM block length that corresponds to the used_length on the migration
      * source (after RAM block sizes were synchronized). Especially, after
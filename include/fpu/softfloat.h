@@ -598,6 +598,17 @@ float32 float32_div(float32, float32, float_status *status);
 float32 float32_rem(float32, float32, float_status *status);
 float32 float32_muladd(float32, float32, float32, int, float_status *status);
 float32 float32_sqrt(float32, float_status *status);
+/*
+ * Apply the operation to @n pairs of lanes, storing into @d; @d may be
+ * the same array as @a or @b.  Results and exception flags are the same
+ * as calling the scalar function on each lane in turn.
+ */
+void float32_add_n(float32 *d, const float32 *a, const float32 *b, size_t n,
+                   float_status *status);
+void float32_sub_n(float32 *d, const float32 *a, const float32 *b, size_t n,
+                   float_status *status);
+void float32_mul_n(float32 *d, const float32 *a, const float32 *b, size_t n,
+                   float_status *status);
 float32 float32_exp2(float32, float_status *status);
 float32 float32_log2(float32, float_status *status);
 FloatRelation float32_compare(float32, float32, float_status *status);
@@ -793,6 +804,12 @@ float64 float64_div(float64, float64, float_status *status);
 float64 float64_rem(float64, float64, float_status *status);
 float64 float64_muladd(float64, float64, float64, int, float_status *status);
 float64 float64_sqrt(float64, float_status *status);
+void float64_add_n(float64 *d, const float64 *a, const float64 *b, size_t n,
+                   float_status *status);
+void float64_sub_n(float64 *d, const float64 *a, const float64 *b, size_t n,
+                   float_status *status);
+void float64_mul_n(float64 *d, const float64 *a, const float64 *b, size_t n,
+                   float_status *status);
 float64 float64_log2(float64, float_status *status);
 FloatRelation float64_compare(float64, float64, float_status *status);
 FloatRelation float64_compare_quiet(float64, float64, float_status *status);
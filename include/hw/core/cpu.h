@@ -233,6 +233,16 @@ struct CPUTLBEntryFull {
     /* @lg_page_size contains the log2 of the page size. */
     uint8_t lg_page_size;
 
+    /*
+     * @lg_map_size, if greater than TARGET_PAGE_BITS, is the log2 of the
+     * naturally aligned region around the page that the guest maps to
+     * contiguous physical memory with the same @attrs, @prot and
+     * @tlb_fill_flags, and whose translation has no further side effects.
+     * It must not exceed @lg_page_size.  Misses elsewhere in the region
+     * may then be filled without calling back into the target.
+     */
+    uint8_t lg_map_size;
+
     /* Additional tlb flags requested by tlb_fill. */
     uint8_t tlb_fill_flags;
 
@@ -277,6 +287,13 @@ typedef struct CPUTLBDesc {
      */
     vaddr large_page_addr;
     vaddr large_page_mask;
+    /*
+     * The most recent fill that reported a @lg_map_size, or -1.  It lies
+     * within the large page region above, so any flush that affects it
+     * also discards it.
+     */
+    vaddr map_fill_addr;
+    CPUTLBEntryFull map_fill;
     /* host time (in ns) at the beginning of the time window */
     int64_t window_begin_ns;
     /* maximum number of entries observed in the window */
@@ -290,6 +307,20 @@ typedef struct CPUTLBDesc {
     CPUTLBEntryFull *fulltlb;
 } CPUTLBDesc;
 
+/* The number of distinct ranges that may be pending before a full flush. */
+#define CPU_TLB_PENDING_FLUSHES 8
+
+/*
+ * A flush of @len bytes from @addr, comparing @bits of the address,
+ * in each mmu_idx of @idxmap.
+ */
+typedef struct CPUTLBFlushRange {
+    vaddr addr;
+    vaddr len;
+    uint16_t idxmap;
+    uint16_t bits;
+} CPUTLBFlushRange;
+
 /*
  * Data elements that are shared between all MMU modes.
  */
@@ -302,6 +333,16 @@ typedef struct CPUTLBCommon {
      * Protected by tlb_c.lock.
      */
     uint16_t dirty;
+    /*
+     * Flushes requested by other cpus and not yet performed: a full flush
+     * of the mmu_idx in pending_full, plus n_pending ranges.  While
+     * pending_queued is set, a work item that will perform them is queued
+     * and further requests are merged in.  Protected by tlb_c.lock.
+     */
+    bool pending_queued;
+    uint16_t pending_full;
+    unsigned n_pending;
+    CPUTLBFlushRange pending[CPU_TLB_PENDING_FLUSHES];
     /*
      * Statistics.  These are not lock protected, but are read and
      * written atomically.  This allows the monitor to print a snapshot
@@ -310,6 +351,7 @@ typedef struct CPUTLBCommon {
     size_t full_flush_count;
     size_t part_flush_count;
     size_t elide_flush_count;
+    size_t merged_flush_count;
 } CPUTLBCommon;
 
 /*
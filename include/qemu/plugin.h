@@ -72,6 +72,10 @@ enum plugin_dyn_cb_type {
     PLUGIN_CB_MEM_REGULAR,
     PLUGIN_CB_INLINE_ADD_U64,
     PLUGIN_CB_INLINE_STORE_U64,
+    PLUGIN_CB_INLINE_MIN_U64,
+    PLUGIN_CB_INLINE_MAX_U64,
+    PLUGIN_CB_INLINE_OR_U64,
+    PLUGIN_CB_MEM_BUFFER,
 };
 
 struct qemu_plugin_regular_cb {
@@ -96,6 +100,13 @@ struct qemu_plugin_conditional_cb {
     uint64_t imm;
 };
 
+struct qemu_plugin_mem_buffer_cb {
+    struct qemu_plugin_mem_buffer *buf;
+    TCGHelperInfo *info;
+    uint64_t pc;
+    enum qemu_plugin_mem_rw rw;
+};
+
 /*
  * A dynamic callback has an insertion point that is determined at run-time.
  * Usually the insertion point is somewhere in the code cache; think for
@@ -107,6 +118,7 @@ struct qemu_plugin_dyn_cb {
         struct qemu_plugin_regular_cb regular;
         struct qemu_plugin_conditional_cb cond;
         struct qemu_plugin_inline_cb inline_insn;
+        struct qemu_plugin_mem_buffer_cb mem_buffer;
     };
 };
 
@@ -128,6 +140,24 @@ struct qemu_plugin_scoreboard {
     QLIST_ENTRY(qemu_plugin_scoreboard) entry;
 };
 
+/*
+ * A memory access buffer keeps one struct qemu_plugin_mem_buffer_entry
+ * per vcpu in a scoreboard, so that it is resized along with the others.
+ */
+struct qemu_plugin_mem_buffer {
+    struct qemu_plugin_scoreboard *score;
+    size_t n_records;
+    qemu_plugin_vcpu_mem_buffer_cb_t cb;
+    void *userp;
+    qemu_plugin_id_t id;
+    QLIST_ENTRY(qemu_plugin_mem_buffer) entry;
+};
+
+struct qemu_plugin_mem_buffer_entry {
+    uint64_t n;
+    qemu_plugin_mem_record records[];
+};
+
 /* Internal context for this TranslationBlock */
 struct qemu_plugin_tb {
     GPtrArray *insns;
@@ -171,6 +201,8 @@ void qemu_plugin_vcpu_mem_cb(CPUState *cpu, uint64_t vaddr,
                              uint64_t value_high,
                              MemOpIdx oi, enum qemu_plugin_mem_rw rw);
 
+void qemu_plugin_mem_buffer_flush_vcpu(uint32_t cpu_index, void *udata);
+
 void qemu_plugin_flush_cb(void);
 
 void qemu_plugin_atexit_cb(void);
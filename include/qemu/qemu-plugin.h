@@ -65,11 +65,16 @@ typedef uint64_t qemu_plugin_id_t;
  *
  * version 4:
  * - added qemu_plugin_read_memory_vaddr
+ *
+ * version 5:
+ * - added qemu_plugin_mem_buffer_{new,free,flush} and
+ *   qemu_plugin_register_vcpu_mem_buffer
+ * - added QEMU_PLUGIN_INLINE_{MIN,MAX,OR}_U64 inline ops
  */
 
 extern QEMU_PLUGIN_EXPORT int qemu_plugin_version;
 
-#define QEMU_PLUGIN_VERSION 4
+#define QEMU_PLUGIN_VERSION 5
 
 /**
  * struct qemu_info_t - system information for plugins
@@ -386,11 +391,19 @@ void qemu_plugin_register_vcpu_tb_exec_cond_cb(struct qemu_plugin_tb *tb,
  *
  * @QEMU_PLUGIN_INLINE_ADD_U64: add an immediate value uint64_t
  * @QEMU_PLUGIN_INLINE_STORE_U64: store an immediate value uint64_t
+ * @QEMU_PLUGIN_INLINE_MIN_U64: keep the minimum of the entry and the
+ *   immediate value uint64_t
+ * @QEMU_PLUGIN_INLINE_MAX_U64: keep the maximum of the entry and the
+ *   immediate value uint64_t
+ * @QEMU_PLUGIN_INLINE_OR_U64: or the entry with an immediate bitmask
  */
 
 enum qemu_plugin_op {
     QEMU_PLUGIN_INLINE_ADD_U64,
     QEMU_PLUGIN_INLINE_STORE_U64,
+    QEMU_PLUGIN_INLINE_MIN_U64,
+    QEMU_PLUGIN_INLINE_MAX_U64,
+    QEMU_PLUGIN_INLINE_OR_U64,
 };
 
 /**
@@ -701,6 +714,97 @@ void qemu_plugin_register_vcpu_mem_inline_per_vcpu(
     qemu_plugin_u64 entry,
     uint64_t imm);
 
+/** struct qemu_plugin_mem_buffer - Opaque handle for a memory access buffer */
+struct qemu_plugin_mem_buffer;
+
+/**
+ * typedef qemu_plugin_mem_record - one buffered memory access
+ * @vaddr: the virtual address of the access
+ * @pc: the virtual address of the instruction performing the access
+ * @info: opaque memory transaction handle, see qemu_plugin_mem_*()
+ */
+typedef struct {
+    uint64_t vaddr;
+    uint64_t pc;
+    qemu_plugin_meminfo_t info;
+} qemu_plugin_mem_record;
+
+/**
+ * typedef qemu_plugin_vcpu_mem_buffer_cb_t - memory buffer callback type
+ * @vcpu_index: the vCPU the accesses took place on
+ * @records: the buffered accesses, oldest first
+ * @n: number of entries in @records
+ * @userdata: any user data provided to qemu_plugin_mem_buffer_new
+ *
+ * @records is only valid for the duration of the callback.
+ */
+typedef void (*qemu_plugin_vcpu_mem_buffer_cb_t)(
+    unsigned int vcpu_index,
+    const qemu_plugin_mem_record *records,
+    size_t n,
+    void *userdata);
+
+/**
+ * qemu_plugin_mem_buffer_new() - alloc a new memory access buffer
+ * @id: the unique plugin id
+ * @n_records: number of accesses each vCPU can buffer
+ * @cb: callback invoked to drain a vCPU's buffer
+ * @userdata: opaque pointer passed to @cb
+ *
+ * Returns a buffer with room for @n_records accesses per vCPU. @cb is
+ * called on the vCPU thread when its buffer is full, when the vCPU
+ * exits, before the atexit callbacks run and on
+ * qemu_plugin_mem_buffer_flush(). The buffer is freed automatically
+ * when the plugin is uninstalled.
+ */
+QEMU_PLUGIN_API
+struct qemu_plugin_mem_buffer *
+qemu_plugin_mem_buffer_new(qemu_plugin_id_t id, size_t n_records,
+                           qemu_plugin_vcpu_mem_buffer_cb_t cb,
+                           void *userdata);
+
+/**
+ * qemu_plugin_mem_buffer_free() - free a memory access buffer
+ * @buf: buffer to free
+ *
+ * Pending records are dropped; call qemu_plugin_mem_buffer_flush()
+ * first to see them. As with scoreboards, no translated code may
+ * still refer to @buf. This may be called from a buffer callback,
+ * including the one of @buf itself.
+ */
+QEMU_PLUGIN_API
+void qemu_plugin_mem_buffer_free(struct qemu_plugin_mem_buffer *buf);
+
+/**
+ * qemu_plugin_mem_buffer_flush() - drain the buffers of all vCPUs
+ * @buf: buffer to drain
+ *
+ * Invokes the callback of @buf for each vCPU with pending records.
+ * This must only be called while the vCPUs are stopped, e.g. from an
+ * atexit callback.
+ */
+QEMU_PLUGIN_API
+void qemu_plugin_mem_buffer_flush(struct qemu_plugin_mem_buffer *buf);
+
+/**
+ * qemu_plugin_register_vcpu_mem_buffer() - buffer memory accesses
+ * @insn: handle for instruction to instrument
+ * @rw: record reads, writes or both
+ * @buf: buffer to append the accesses to
+ *
+ * Unlike qemu_plugin_register_vcpu_mem_cb(), this does not call into
+ * the plugin for every access of the instruction. The generated code
+ * appends a qemu_plugin_mem_record to the vCPU's buffer instead, and
+ * the plugin only sees the accesses once the buffer is drained.
+ *
+ * As the buffer is drained after the fact, qemu_plugin_get_hwaddr()
+ * cannot be used on the records it holds.
+ */
+QEMU_PLUGIN_API
+void qemu_plugin_register_vcpu_mem_buffer(struct qemu_plugin_insn *insn,
+                                          enum qemu_plugin_mem_rw rw,
+                                          struct qemu_plugin_mem_buffer *buf);
+
 /**
  * qemu_plugin_request_time_control() - request the ability to control time
  *
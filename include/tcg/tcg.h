@@ -30,6 +30,7 @@
 #include "qemu/bitops.h"
 #include "qemu/plugin.h"
 #include "qemu/queue.h"
+#include "qemu/stats64.h"
 #include "tcg/tcg-mo.h"
 #include "tcg-target-reg-bits.h"
 #include "tcg-target.h"
@@ -221,6 +222,12 @@ struct TCGLabel {
     QSIMPLEQ_HEAD(, TCGLabelUse) branches;
     QSIMPLEQ_HEAD(, TCGRelocation) relocs;
     QSIMPLEQ_ENTRY(TCGLabel) next;
+    /*
+     * During register allocation: the number of branches to the label
+     * seen so far, and the register holding each global on all of them.
+     */
+    unsigned nb_entry_branches;
+    TCGTemp **entry_regs;
 };
 
 typedef struct TCGPool {
@@ -465,6 +472,7 @@ struct TCGContext {
     uint8_t tlb_dyn_max_bits;
     uint8_t insn_start_words;
     TCGBar guest_mo;
+    bool skip_optimize;           /* TB is not expected to be reused */
 
     TCGRegSet reserved_regs;
     intptr_t current_frame_offset;
@@ -544,6 +552,13 @@ struct TCGContext {
        It does not take into account fixed registers */
     TCGTemp *reg_to_temp[TCG_TARGET_NB_REGS];
 
+    /* Register allocator statistics, see tcg_dump_op_count(). */
+    size_t stat_ops;
+    size_t stat_temp_loads;
+    size_t stat_temp_stores;
+    size_t stat_label_kept;
+    Stat64 stat_opt_time_ns;
+
     uint16_t gen_insn_end_off[TCG_MAX_INSNS];
     uint64_t *gen_insn_data;
 
@@ -742,9 +757,11 @@ void tcg_pool_reset(TCGContext *s);
 TranslationBlock *tcg_tb_alloc(TCGContext *s);
 
 void tcg_region_reset_all(void);
+bool tcg_region_evict(void (*evict_tb)(TranslationBlock *tb));
 
 size_t tcg_code_size(void);
 size_t tcg_code_capacity(void);
+void tcg_dump_op_count(GString *buf);
 
 void tcg_tb_insert(TranslationBlock *tb);
 void tcg_tb_remove(TranslationBlock *tb);
@@ -35,4 +35,10 @@ void preexit_cleanup(CPUArchState *env, int code)
         gdb_exit(code);
         qemu_plugin_user_exit();
         perf_exit();
+        if (qemu_loglevel_mask(LOG_TB_STATS)) {
+            g_autoptr(GString) buf = g_string_new("");
+
+            tb_dump_stats(buf);
+            qemu_log("%s", buf->str);
+        }
 }
@@ -13852,6 +13852,48 @@ static abi_long do_syscall1(CPUArchState *cpu_env, int num, abi_long arg1,
     return ret;
 }
 
+/*
+ * When guest and host share the syscall ABI (same numbers, same argument
+ * registers and widths), syscalls that only take and return integers and
+ * need none of the emulation in do_syscall1() are forwarded unchanged.
+ * Syscalls taking guest pointers are never passed through: the guest
+ * memory must be validated, and blocking ones must use safe_syscall.
+ */
+#if (defined(TARGET_X86_64) && defined(__x86_64__)) || \
+    (defined(TARGET_AARCH64) && defined(__aarch64__)) || \
+    (defined(TARGET_RISCV64) && defined(__riscv) && __riscv_xlen == 64) || \
+    (defined(TARGET_LOONGARCH64) && defined(__loongarch64))
+#define SYSCALL_PASSTHROUGH
+#endif
+
+#ifdef SYSCALL_PASSTHROUGH
+static bool syscall_passthrough(int num)
+{
+    switch (num) {
+    case TARGET_NR_getpid:
+    case TARGET_NR_getppid:
+    case TARGET_NR_gettid:
+    case TARGET_NR_getuid:
+    case TARGET_NR_geteuid:
+    case TARGET_NR_getgid:
+    case TARGET_NR_getegid:
+    case TARGET_NR_getpgid:
+    case TARGET_NR_setpgid:
+    case TARGET_NR_getsid:
+    case TARGET_NR_setsid:
+    case TARGET_NR_umask:
+    case TARGET_NR_sched_yield:
+    case TARGET_NR_lseek:
+    case TARGET_NR_fchmod:
+    case TARGET_NR_fsync:
+    case TARGET_NR_fdatasync:
+        return true;
+    default:
+        return false;
+    }
+}
+#endif
+
 abi_long do_syscall(CPUArchState *cpu_env, int num, abi_long arg1,
                     abi_long arg2, abi_long arg3, abi_long arg4,
                     abi_long arg5, abi_long arg6, abi_long arg7,
@@ -13881,8 +13923,15 @@ abi_long do_syscall(CPUArchState *cpu_env, int num, abi_long arg1,
         print_syscall(cpu_env, num, arg1, arg2, arg3, arg4, arg5, arg6);
     }
 
-    ret = do_syscall1(cpu_env, num, arg1, arg2, arg3, arg4,
-                      arg5, arg6, arg7, arg8);
+#ifdef SYSCALL_PASSTHROUGH
+    if (syscall_passthrough(num)) {
+        ret = get_errno(syscall(num, arg1, arg2, arg3, arg4, arg5, arg6));
+    } else
+#endif
+    {
+        ret = do_syscall1(cpu_env, num, arg1, arg2, arg3, arg4,
+                          arg5, arg6, arg7, arg8);
+    }
 
     if (unlikely(qemu_loglevel_mask(LOG_STRACE))) {
         print_syscall_ret(cpu_env, num, ret, arg1, arg2,
@@ -165,6 +165,11 @@ void hmp_info_migrate(Monitor *mon, const QDict *qdict)
                        info->cpu_throttle_percentage);
     }
 
+    if (info->has_cpu_throttle_target) {
+        monitor_printf(mon, "cpu throttle target: %" PRId64 "\n",
+                       info->cpu_throttle_target);
+    }
+
     if (info->has_dirty_limit_throttle_time_per_round) {
         monitor_printf(mon, "dirty-limit throttle time: %" PRIu64 " us\n",
                        info->dirty_limit_throttle_time_per_round);
@@ -264,6 +269,10 @@ void hmp_info_migrate_parameters(Monitor *mon, const QDict *qdict)
         monitor_printf(mon, "%s: %s\n",
             MigrationParameter_str(MIGRATION_PARAMETER_CPU_THROTTLE_TAILSLOW),
             params->cpu_throttle_tailslow ? "on" : "off");
+        assert(params->has_cpu_throttle_adaptive);
+        monitor_printf(mon, "%s: %s\n",
+            MigrationParameter_str(MIGRATION_PARAMETER_CPU_THROTTLE_ADAPTIVE),
+            params->cpu_throttle_adaptive ? "on" : "off");
         assert(params->has_max_cpu_throttle);
         monitor_printf(mon, "%s: %u\n",
             MigrationParameter_str(MIGRATION_PARAMETER_MAX_CPU_THROTTLE),
@@ -512,6 +521,10 @@ void hmp_migrate_set_parameter(Monitor *mon, const QDict *qdict)
         p->has_cpu_throttle_tailslow = true;
         visit_type_bool(v, param, &p->cpu_throttle_tailslow, &err);
         break;
+    case MIGRATION_PARAMETER_CPU_THROTTLE_ADAPTIVE:
+        p->has_cpu_throttle_adaptive = true;
+        visit_type_bool(v, param, &p->cpu_throttle_adaptive, &err);
+        break;
     case MIGRATION_PARAMETER_MAX_CPU_THROTTLE:
         p->has_max_cpu_throttle = true;
         visit_type_uint8(v, param, &p->max_cpu_throttle, &err);
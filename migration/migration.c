@@ -1208,6 +1208,9 @@ static void populate_ram_info(MigrationInfo *info, MigrationState *s)
         info->cpu_throttle_percentage = cpu_throttle_get_percentage();
     }
 
+    info->cpu_throttle_target = ram_cpu_throttle_target();
+    info->has_cpu_throttle_target = info->cpu_throttle_target >= 0;
+
     if (s->state != MIGRATION_STATUS_COMPLETED) {
         info->ram->remaining = ram_bytes_remaining();
         info->ram->dirty_pages_rate =
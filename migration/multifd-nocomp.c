@@ -152,7 +152,9 @@ static void multifd_nocomp_recv_cleanup(MultiFDRecvParams *p)
 
 static int multifd_nocomp_recv(MultiFDRecvParams *p, Error **errp)
 {
+    uint32_t page_size = multifd_ram_page_size();
     uint32_t flags;
+    int niov = 0;
 
     if (migrate_mapped_ram()) {
         return multifd_file_recv_data(p, errp);
@@ -172,12 +174,25 @@ static int multifd_nocomp_recv(MultiFDRecvParams *p, Error **errp)
         return 0;
     }
 
+    /*
+     * Pages are read straight into guest RAM.  The source usually sends
+     * runs of consecutive pages, so merge them into a single iovec: this
+     * keeps the readv() calls large and the iovec walk short.
+     */
     for (int i = 0; i < p->normal_num; i++) {
-        p->iov[i].iov_base = p->host + p->normal[i];
-        p->iov[i].iov_len = multifd_ram_page_size();
+        uint8_t *host = p->host + p->normal[i];
+        struct iovec *last = niov ? &p->iov[niov - 1] : NULL;
+
+        if (last && (uint8_t *)last->iov_base + last->iov_len == host) {
+            last->iov_len += page_size;
+        } else {
+            p->iov[niov].iov_base = host;
+            p->iov[niov].iov_len = page_size;
+            niov++;
+        }
         ramblock_recv_bitmap_set_offset(p->block, p->normal[i]);
     }
-    return qio_channel_readv_all(p->c, p->iov, p->normal_num, errp);
+    return qio_channel_readv_all(p->c, p->iov, niov, errp);
 }
 
 static void multifd_pages_reset(MultiFDPages_t *pages)
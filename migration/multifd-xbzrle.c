@@ -0,0 +1,370 @@
+/*
+ * Multifd XBZRLE delta encoding implementation
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/bswap.h"
+#include "qemu/host-utils.h"
+#include "qemu/lockable.h"
+#include "qemu/thread.h"
+#include "exec/ramblock.h"
+#include "exec/target_page.h"
+#include "qapi/error.h"
+#include "migration.h"
+#include "migration-stats.h"
+#include "options.h"
+#include "page_cache.h"
+#include "xbzrle.h"
+#include "multifd.h"
+
+/*
+ * Each normal page of a packet is sent as a be32 length followed by
+ * that many bytes.  A length equal to the page size means the page
+ * is sent verbatim, anything smaller is an XBZRLE delta against the
+ * previous copy of the page, and zero means the page is unchanged.
+ *
+ * The destination applies deltas on top of guest RAM, so the source
+ * must remember exactly what it last sent for each page.  The page
+ * may be sent by any channel, so the cache is keyed by page and split
+ * into independently locked shards rather than per channel.
+ */
+#define XBZRLE_RECORD_HDR sizeof(uint32_t)
+
+typedef struct {
+    QemuMutex lock;
+    PageCache *cache;
+} XbzrleShard;
+
+static struct {
+    XbzrleShard *shards;
+    unsigned nshards;
+    unsigned users;
+} xbzrle_send;
+
+struct xbzrle_data {
+    /* copy of the page being encoded, the guest may still write it */
+    uint8_t *buf;
+    /* outgoing or incoming records */
+    uint8_t *zbuff;
+    /* size of zbuff */
+    uint32_t zbuff_len;
+};
+
+static uint32_t multifd_xbzrle_buff_len(void)
+{
+    return multifd_ram_page_count() *
+           (XBZRLE_RECORD_HDR + multifd_ram_page_size());
+}
+
+static XbzrleShard *multifd_xbzrle_shard(ram_addr_t addr, uint64_t *key)
+{
+    uint64_t page = addr / multifd_ram_page_size();
+
+    /* Keep the keys of each shard dense, so that no cache slot is unused */
+    *key = (page / xbzrle_send.nshards) * multifd_ram_page_size();
+    return &xbzrle_send.shards[page % xbzrle_send.nshards];
+}
+
+static void multifd_xbzrle_cache_fini(void)
+{
+    for (unsigned i = 0; i < xbzrle_send.nshards; i++) {
+        XbzrleShard *s = &xbzrle_send.shards[i];
+
+        if (s->cache) {
+            cache_fini(s->cache);
+        }
+        qemu_mutex_destroy(&s->lock);
+    }
+    g_free(xbzrle_send.shards);
+    xbzrle_send.shards = NULL;
+    xbzrle_send.nshards = 0;
+}
+
+static int multifd_xbzrle_cache_init(Error **errp)
+{
+    uint32_t page_size = multifd_ram_page_size();
+    unsigned nshards = migrate_multifd_channels();
+    uint64_t shard_pages;
+
+    shard_pages = migrate_xbzrle_cache_size() / nshards / page_size;
+    shard_pages = pow2floor(MAX(shard_pages, 1));
+
+    xbzrle_send.nshards = nshards;
+    xbzrle_send.shards = g_new0(XbzrleShard, nshards);
+    for (unsigned i = 0; i < nshards; i++) {
+        qemu_mutex_init(&xbzrle_send.shards[i].lock);
+    }
+    for (unsigned i = 0; i < nshards; i++) {
+        XbzrleShard *s = &xbzrle_send.shards[i];
+
+        s->cache = cache_init(shard_pages * page_size, page_size, errp);
+        if (!s->cache) {
+            multifd_xbzrle_cache_fini();
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int multifd_xbzrle_send_setup(MultiFDSendParams *p, Error **errp)
+{
+    struct xbzrle_data *x;
+
+    if (migrate_zero_page_detection() == ZERO_PAGE_DETECTION_LEGACY) {
+        /*
+         * Zero pages would then reach the destination on the main
+         * channel, behind the back of the page cache.
+         */
+        error_setg(errp, "multifd %u: xbzrle is not compatible with "
+                   "legacy zero page detection", p->id);
+        return -1;
+    }
+
+    if (!xbzrle_send.users && multifd_xbzrle_cache_init(errp)) {
+        return -1;
+    }
+    xbzrle_send.users++;
+
+    x = g_new0(struct xbzrle_data, 1);
+    x->buf = g_malloc(multifd_ram_page_size());
+    x->zbuff_len = multifd_xbzrle_buff_len();
+    x->zbuff = g_malloc(x->zbuff_len);
+    p->compress_data = x;
+
+    /* Needs 2 IOVs, one for packet header and one for the records */
+    p->iov = g_new0(struct iovec, 2);
+    return 0;
+}
+
+static void multifd_xbzrle_send_cleanup(MultiFDSendParams *p, Error **errp)
+{
+    struct xbzrle_data *x = p->compress_data;
+
+    if (!x) {
+        return;
+    }
+
+    g_free(x->buf);
+    g_free(x->zbuff);
+    g_free(x);
+    p->compress_data = NULL;
+
+    g_free(p->iov);
+    p->iov = NULL;
+
+    if (!--xbzrle_send.users) {
+        multifd_xbzrle_cache_fini();
+    }
+}
+
+/*
+ * Encode one page into @out, returning the record length.  The cache
+ * is updated to what the destination will hold after this record.
+ */
+static uint32_t multifd_xbzrle_encode_page(struct xbzrle_data *x,
+                                           ram_addr_t addr, uint8_t *page,
+                                           uint8_t *out, uint64_t generation)
+{
+    uint32_t page_size = multifd_ram_page_size();
+    uint8_t *cached;
+    uint64_t key;
+    XbzrleShard *s = multifd_xbzrle_shard(addr, &key);
+    int len;
+
+    QEMU_LOCK_GUARD(&s->lock);
+
+    if (!cache_is_cached(s->cache, key, generation)) {
+        memcpy(out, page, page_size);
+        /* May fail if the slot is fresh; the page then stays uncached */
+        cache_insert(s->cache, key, out, generation);
+        return page_size;
+    }
+
+    cached = get_cached_data(s->cache, key);
+    memcpy(x->buf, page, page_size);
+
+    /* Only worth it if the delta is smaller than the page */
+    len = xbzrle_encode_buffer(cached, x->buf, page_size, out, page_size - 1);
+    if (len < 0) {
+        memcpy(out, x->buf, page_size);
+        len = page_size;
+    }
+    if (len != 0) {
+        memcpy(cached, x->buf, page_size);
+    }
+    return len;
+}
+
+/* The destination clears pages sent as zero; keep the cache in sync. */
+static void multifd_xbzrle_zero_page(ram_addr_t addr, uint64_t generation)
+{
+    uint64_t key;
+    XbzrleShard *s = multifd_xbzrle_shard(addr, &key);
+
+    QEMU_LOCK_GUARD(&s->lock);
+
+    if (cache_is_cached(s->cache, key, generation)) {
+        memset(get_cached_data(s->cache, key), 0, multifd_ram_page_size());
+    }
+}
+
+static int multifd_xbzrle_send_prepare(MultiFDSendParams *p, Error **errp)
+{
+    MultiFDPages_t *pages = &p->data->u.ram;
+    struct xbzrle_data *x = p->compress_data;
+    uint64_t generation = stat64_get(&mig_stats.dirty_sync_count);
+    uint32_t out_size = 0;
+    bool has_normal;
+    uint32_t i;
+
+    /* Sorts zero pages to the end of the offset array */
+    has_normal = multifd_send_prepare_common(p);
+
+    /*
+     * The destination clears zero pages even when the packet has no
+     * normal page, so the cache must always learn about them.
+     */
+    for (i = pages->normal_num; i < pages->num; i++) {
+        multifd_xbzrle_zero_page(pages->block->offset + pages->offset[i],
+                                 generation);
+    }
+
+    if (!has_normal) {
+        goto out;
+    }
+
+    for (i = 0; i < pages->normal_num; i++) {
+        ram_addr_t offset = pages->offset[i];
+        uint8_t *rec = x->zbuff + out_size;
+        uint32_t len;
+
+        len = multifd_xbzrle_encode_page(x, pages->block->offset + offset,
+                                         pages->block->host + offset,
+                                         rec + XBZRLE_RECORD_HDR, generation);
+        stl_be_p(rec, len);
+        out_size += XBZRLE_RECORD_HDR + len;
+    }
+
+    p->iov[p->iovs_num].iov_base = x->zbuff;
+    p->iov[p->iovs_num].iov_len = out_size;
+    p->iovs_num++;
+    p->next_packet_size = out_size;
+
+out:
+    p->flags |= MULTIFD_FLAG_XBZRLE;
+    multifd_send_fill_packet(p);
+    return 0;
+}
+
+static int multifd_xbzrle_recv_setup(MultiFDRecvParams *p, Error **errp)
+{
+    struct xbzrle_data *x = g_new0(struct xbzrle_data, 1);
+
+    x->zbuff_len = multifd_xbzrle_buff_len();
+    x->zbuff = g_malloc(x->zbuff_len);
+    p->compress_data = x;
+    return 0;
+}
+
+static void multifd_xbzrle_recv_cleanup(MultiFDRecvParams *p)
+{
+    struct xbzrle_data *x = p->compress_data;
+
+    if (!x) {
+        return;
+    }
+    g_free(x->zbuff);
+    g_free(x);
+    p->compress_data = NULL;
+}
+
+static int multifd_xbzrle_recv(MultiFDRecvParams *p, Error **errp)
+{
+    struct xbzrle_data *x = p->compress_data;
+    uint32_t in_size = p->next_packet_size;
+    uint32_t page_size = multifd_ram_page_size();
+    uint32_t flags = p->flags & MULTIFD_FLAG_COMPRESSION_MASK;
+    uint32_t pos = 0;
+    int ret;
+    int i;
+
+    if (flags != MULTIFD_FLAG_XBZRLE) {
+        error_setg(errp, "multifd %u: flags received %x flags expected %x",
+                   p->id, flags, MULTIFD_FLAG_XBZRLE);
+        return -1;
+    }
+
+    multifd_recv_zero_page_process(p);
+
+    if (!p->normal_num) {
+        assert(in_size == 0);
+        return 0;
+    }
+
+    if (in_size > x->zbuff_len) {
+        error_setg(errp, "multifd %u: packet size %u exceeds %u",
+                   p->id, in_size, x->zbuff_len);
+        return -1;
+    }
+
+    ret = qio_channel_read_all(p->c, (void *)x->zbuff, in_size, errp);
+    if (ret != 0) {
+        return ret;
+    }
+
+    for (i = 0; i < p->normal_num; i++) {
+        uint8_t *page = p->host + p->normal[i];
+        uint32_t len;
+
+        if (in_size - pos < XBZRLE_RECORD_HDR) {
+            error_setg(errp, "multifd %u: truncated xbzrle packet", p->id);
+            return -1;
+        }
+        len = ldl_be_p(x->zbuff + pos);
+        pos += XBZRLE_RECORD_HDR;
+        if (len > page_size || len > in_size - pos) {
+            error_setg(errp, "multifd %u: invalid xbzrle record length %u",
+                       p->id, len);
+            return -1;
+        }
+
+        ramblock_recv_bitmap_set_offset(p->block, p->normal[i]);
+        if (len == page_size) {
+            memcpy(page, x->zbuff + pos, page_size);
+        } else if (len &&
+                   xbzrle_decode_buffer(x->zbuff + pos, len,
+                                        page, page_size) < 0) {
+            error_setg(errp, "multifd %u: failed to decode xbzrle page",
+                       p->id);
+            return -1;
+        }
+        pos += len;
+    }
+
+    if (pos != in_size) {
+        error_setg(errp, "multifd %u: packet size received %u size used %u",
+                   p->id, in_size, pos);
+        return -1;
+    }
+
+    return 0;
+}
+
+static const MultiFDMethods multifd_xbzrle_ops = {
+    .send_setup = multifd_xbzrle_send_setup,
+    .send_cleanup = multifd_xbzrle_send_cleanup,
+    .send_prepare = multifd_xbzrle_send_prepare,
+    .recv_setup = multifd_xbzrle_recv_setup,
+    .recv_cleanup = multifd_xbzrle_recv_cleanup,
+    .recv = multifd_xbzrle_recv
+};
+
+static void multifd_xbzrle_register(void)
+{
+    multifd_register_ops(MULTIFD_COMPRESSION_XBZRLE, &multifd_xbzrle_ops);
+}
+
+migration_init(multifd_xbzrle_register);
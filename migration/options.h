@@ -27,6 +27,7 @@ extern const size_t migration_properties_count;
 
 bool migrate_auto_converge(void);
 bool migrate_colo(void);
+bool migrate_defer_hot_pages(void);
 bool migrate_dirty_bitmaps(void);
 bool migrate_events(void);
 bool migrate_mapped_ram(void);
@@ -65,6 +66,7 @@ const BitmapMigrationNodeAliasList *migrate_block_bitmap_mapping(void);
 bool migrate_has_block_bitmap_mapping(void);
 
 uint32_t migrate_checkpoint_delay(void);
+bool migrate_cpu_throttle_adaptive(void);
 uint8_t migrate_cpu_throttle_increment(void);
 uint8_t migrate_cpu_throttle_initial(void);
 bool migrate_cpu_throttle_tailslow(void);
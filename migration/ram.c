@@ -104,6 +104,16 @@
  */
 #define MAPPED_RAM_FILE_OFFSET_ALIGNMENT 0x100000
 
+/*
+ * With defer-hot-pages, dirty page frequency is tracked per chunk of at
+ * least 1 << HOT_PAGES_SHIFT_MIN target pages.  A chunk found dirty at
+ * HOT_PAGES_SYNCS successive bitmap syncs is hot, and is only sent in one
+ * round out of HOT_PAGES_DEFER_ROUNDS until the final stage or postcopy.
+ */
+#define HOT_PAGES_SHIFT_MIN    9
+#define HOT_PAGES_SYNCS        3
+#define HOT_PAGES_DEFER_ROUNDS 4
+
 /*
  * When doing mapped-ram migration, this is the amount we read from
  * the pages region in the migration file at a time.
@@ -370,6 +380,8 @@ struct RAMState {
     uint32_t last_version;
     /* How many times we have dirty too many pages */
     int dirty_rate_high_cnt;
+    /* Throttle last chosen by adaptive auto-converge, -1 if none */
+    int throttle_target;
     /* these variables are used for bitmap sync */
     /* last time we did a full bitmap_sync */
     int64_t time_last_bitmap_sync;
@@ -394,6 +406,8 @@ struct RAMState {
     uint64_t target_page_count;
     /* number of dirty bits in the bitmap */
     uint64_t migration_dirty_pages;
+    /* Did the last round end with only deferred hot pages left dirty? */
+    bool hot_pages_deferred;
     /*
      * Protects:
      * - dirty/clear bitmap
@@ -567,6 +581,59 @@ static void mig_throttle_guest_down(uint64_t bytes_dirty_period,
     }
 }
 
+/**
+ * mig_throttle_guest_adapt: set the guest throttle from the dirty rate
+ *
+ * Assume the guest dirties memory in proportion to the CPU time it gets,
+ * and pick the throttle that would have brought the dirty rate of the
+ * last period down to the threshold.  Raise the throttle to it at once,
+ * but release it by at most cpu-throttle-increment per period, so that a
+ * single quiet period does not make it oscillate.
+ */
+static void mig_throttle_guest_adapt(RAMState *rs, uint64_t bytes_dirty_period,
+                                     uint64_t bytes_dirty_threshold)
+{
+    int pct_increment = migrate_cpu_throttle_increment();
+    int pct_max = migrate_max_cpu_throttle();
+    int throttle_now = 0;
+    uint64_t cpu_now, cpu_ideal;
+    int target;
+
+    /* Nothing was transferred, so there is nothing to predict from */
+    if (!bytes_dirty_threshold) {
+        return;
+    }
+
+    if (cpu_throttle_active()) {
+        throttle_now = cpu_throttle_get_percentage();
+    }
+    cpu_now = 100 - throttle_now;
+    if (bytes_dirty_period > bytes_dirty_threshold) {
+        cpu_ideal = cpu_now * bytes_dirty_threshold / bytes_dirty_period;
+    } else {
+        cpu_ideal = 100;
+    }
+    target = MIN(100 - (int)MIN(cpu_ideal, 100), pct_max);
+
+    trace_migration_throttle_adaptive(bytes_dirty_period,
+                                      bytes_dirty_threshold, target);
+    qatomic_set(&rs->throttle_target, target);
+
+    if (target < throttle_now) {
+        target = MAX(target, throttle_now - pct_increment);
+    }
+    if (target > 0) {
+        cpu_throttle_set(target);
+    } else if (throttle_now) {
+        cpu_throttle_stop();
+    }
+}
+
+int ram_cpu_throttle_target(void)
+{
+    return ram_state ? qatomic_read(&ram_state->throttle_target) : -1;
+}
+
 void mig_throttle_counter_reset(void)
 {
     RAMState *rs = ram_state;
@@ -698,6 +765,19 @@ static int save_xbzrle_page(RAMState *rs, PageSearchStatus *pss,
     return 1;
 }
 
+/* Whether the current round may leave hot chunks dirty */
+static bool ram_defer_hot_pages(RAMState *rs)
+{
+    return migrate_defer_hot_pages() && !rs->last_stage &&
+           !migration_in_postcopy() &&
+           stat64_get(&mig_stats.dirty_sync_count) % HOT_PAGES_DEFER_ROUNDS;
+}
+
+static bool ramblock_page_is_hot(RAMBlock *rb, unsigned long page)
+{
+    return rb->hotness[page >> rb->hotness_shift] >= HOT_PAGES_SYNCS;
+}
+
 /**
  * pss_find_next_dirty: find the next dirty page of current ramblock
  *
@@ -731,6 +811,17 @@ static void pss_find_next_dirty(PageSearchStatus *pss)
     }
 
     pss->page = find_next_bit(bitmap, size, pss->page);
+
+    /* Skip hot chunks; they stay dirty and are sent in a later round */
+    if (rb->hotness && !pss->host_page_sending &&
+        ram_defer_hot_pages(ram_state)) {
+        while (pss->page < size && ramblock_page_is_hot(rb, pss->page)) {
+            unsigned long next = ROUND_UP(pss->page + 1,
+                                          1UL << rb->hotness_shift);
+
+            pss->page = find_next_bit(bitmap, size, next);
+        }
+    }
 }
 
 static void migration_clear_memory_region_dirty_bitmap(RAMBlock *rb,
@@ -922,6 +1013,29 @@ static void ramblock_sync_dirty_bitmap(RAMState *rs, RAMBlock *rb)
     rs->num_dirty_pages_period += new_dirty_pages;
 }
 
+/*
+ * Count, for each chunk, the successive syncs that found it dirty.  The
+ * previous round sent every page that was not deferred, so a dirty bit
+ * here means the chunk was written during that round or was held back
+ * as hot.
+ */
+static void ramblock_update_hotness(RAMBlock *rb)
+{
+    unsigned long size = rb->used_length >> TARGET_PAGE_BITS;
+    unsigned long chunk = 1UL << rb->hotness_shift;
+    unsigned long i, start;
+
+    for (i = 0, start = 0; start < size; i++, start += chunk) {
+        unsigned long end = MIN(start + chunk, size);
+
+        if (find_next_bit(rb->bmap, end, start) < end) {
+            rb->hotness[i] = MIN(rb->hotness[i] + 1, UINT8_MAX);
+        } else {
+            rb->hotness[i] = 0;
+        }
+    }
+}
+
 /**
  * ram_pagesize_summary: calculate all the pagesizes of a VM
  *
@@ -1021,6 +1135,14 @@ static void migration_trigger_throttle(RAMState *rs)
     uint64_t bytes_dirty_period = rs->num_dirty_pages_period * TARGET_PAGE_SIZE;
     uint64_t bytes_dirty_threshold = bytes_xfer_period * threshold / 100;
 
+    /* Once started, adaptive throttling follows every period. */
+    if (migrate_auto_converge() && migrate_cpu_throttle_adaptive() &&
+        cpu_throttle_active()) {
+        mig_throttle_guest_adapt(rs, bytes_dirty_period,
+                                 bytes_dirty_threshold);
+        return;
+    }
+
     /*
      * The following detection logic can be refined later. For now:
      * Check to see if the ratio between dirtied bytes and the approx.
@@ -1033,8 +1155,13 @@ static void migration_trigger_throttle(RAMState *rs)
         rs->dirty_rate_high_cnt = 0;
         if (migrate_auto_converge()) {
             trace_migration_throttle();
-            mig_throttle_guest_down(bytes_dirty_period,
-                                    bytes_dirty_threshold);
+            if (migrate_cpu_throttle_adaptive()) {
+                mig_throttle_guest_adapt(rs, bytes_dirty_period,
+                                         bytes_dirty_threshold);
+            } else {
+                mig_throttle_guest_down(bytes_dirty_period,
+                                        bytes_dirty_threshold);
+            }
         } else if (migrate_dirty_limit()) {
             migration_dirty_limit_guest();
         }
@@ -1047,6 +1174,7 @@ static void migration_bitmap_sync(RAMState *rs, bool last_stage)
     int64_t end_time;
 
     stat64_add(&mig_stats.dirty_sync_count, 1);
+    rs->hot_pages_deferred = false;
 
     if (!rs->time_last_bitmap_sync) {
         rs->time_last_bitmap_sync = qemu_clock_get_ms(QEMU_CLOCK_REALTIME);
@@ -1059,6 +1187,9 @@ static void migration_bitmap_sync(RAMState *rs, bool last_stage)
         WITH_RCU_READ_LOCK_GUARD() {
             RAMBLOCK_FOREACH_NOT_IGNORED(block) {
                 ramblock_sync_dirty_bitmap(rs, block);
+                if (block->hotness) {
+                    ramblock_update_hotness(block);
+                }
             }
             stat64_set(&mig_stats.dirty_bytes_last_sync, ram_bytes_remaining());
         }
@@ -1315,6 +1446,9 @@ static int find_dirty_block(RAMState *rs, PageSearchStatus *pss)
          * We've been once around the RAM and haven't found anything.
          * Give up.
          */
+        if (rs->migration_dirty_pages && ram_defer_hot_pages(rs)) {
+            rs->hot_pages_deferred = true;
+        }
         return PAGE_ALL_CLEAN;
     }
     if (!offset_in_ramblock(pss->block,
@@ -2361,6 +2495,8 @@ static void ram_bitmaps_destroy(void)
         block->bmap = NULL;
         g_free(block->file_bmap);
         block->file_bmap = NULL;
+        g_free(block->hotness);
+        block->hotness = NULL;
     }
 }
 
@@ -2702,6 +2838,7 @@ static bool ram_state_init(RAMState **rsp, Error **errp)
     qemu_mutex_init(&(*rsp)->src_page_req_mutex);
     QSIMPLEQ_INIT(&(*rsp)->src_page_requests);
     (*rsp)->ram_bytes_total = ram_bytes_total();
+    (*rsp)->throttle_target = -1;
 
     /*
      * Count the total number of pages used by ram blocks not including any
@@ -2752,6 +2889,13 @@ static void ram_list_init_bitmaps(void)
             }
             block->clear_bmap_shift = shift;
             block->clear_bmap = bitmap_new(clear_bmap_size(pages, shift));
+            if (migrate_defer_hot_pages()) {
+                /* Never split a host page across chunks */
+                block->hotness_shift = MAX(HOT_PAGES_SHIFT_MIN,
+                    ctz64(qemu_ram_pagesize(block) >> TARGET_PAGE_BITS));
+                block->hotness = g_new0(uint8_t,
+                    DIV_ROUND_UP(pages, 1UL << block->hotness_shift));
+            }
         }
     }
 }
@@ -3312,6 +3456,14 @@ static void ram_state_pending_estimate(void *opaque, uint64_t *must_precopy,
 
     uint64_t remaining_size = rs->migration_dirty_pages * TARGET_PAGE_SIZE;
 
+    /*
+     * Deferred hot pages cannot be sent before the next bitmap sync;
+     * report them as done so that the exact (syncing) path is taken.
+     */
+    if (rs->hot_pages_deferred) {
+        remaining_size = 0;
+    }
+
     if (migrate_postcopy_ram()) {
         /* We can do postcopy, and all the data is postcopiable */
         *can_postcopy += remaining_size;
@@ -201,6 +201,13 @@ void qemu_plugin_register_vcpu_mem_inline_per_vcpu(
     plugin_register_inline_op_on_entry(&insn->mem_cbs, rw, op, entry, imm);
 }
 
+void qemu_plugin_register_vcpu_mem_buffer(struct qemu_plugin_insn *insn,
+                                          enum qemu_plugin_mem_rw rw,
+                                          struct qemu_plugin_mem_buffer *buf)
+{
+    plugin_register_vcpu_mem_buffer(&insn->mem_cbs, rw, buf, insn->vaddr);
+}
+
 void qemu_plugin_register_vcpu_tb_trans_cb(qemu_plugin_id_t id,
                                            qemu_plugin_vcpu_tb_trans_cb_t cb)
 {
@@ -598,6 +605,24 @@ void qemu_plugin_scoreboard_free(struct qemu_plugin_scoreboard *score)
     plugin_scoreboard_free(score);
 }
 
+struct qemu_plugin_mem_buffer *
+qemu_plugin_mem_buffer_new(qemu_plugin_id_t id, size_t n_records,
+                           qemu_plugin_vcpu_mem_buffer_cb_t cb,
+                           void *userdata)
+{
+    return plugin_mem_buffer_new(id, n_records, cb, userdata);
+}
+
+void qemu_plugin_mem_buffer_free(struct qemu_plugin_mem_buffer *buf)
+{
+    plugin_mem_buffer_free(buf);
+}
+
+void qemu_plugin_mem_buffer_flush(struct qemu_plugin_mem_buffer *buf)
+{
+    plugin_mem_buffer_flush(buf);
+}
+
 void *qemu_plugin_scoreboard_find(struct qemu_plugin_scoreboard *score,
                                   unsigned int vcpu_index)
 {
@@ -283,10 +283,90 @@ void qemu_plugin_vcpu_init_hook(CPUState *cpu)
     async_run_on_cpu(cpu, qemu_plugin_vcpu_init__async, RUN_ON_CPU_NULL);
 }
 
+static struct qemu_plugin_mem_buffer_entry *
+plugin_mem_buffer_entry(struct qemu_plugin_mem_buffer *buf,
+                        unsigned int cpu_index)
+{
+    char *base_ptr = buf->score->data->data;
+    return (struct qemu_plugin_mem_buffer_entry *)
+        (base_ptr + cpu_index * g_array_get_element_size(buf->score->data));
+}
+
+/*
+ * Disable CFI checks.
+ * The callback function has been loaded from an external library so we do not
+ * have type information
+ */
+QEMU_DISABLE_CFI
+static void plugin_mem_buffer_drain(struct qemu_plugin_mem_buffer *buf,
+                                    unsigned int cpu_index)
+{
+    struct qemu_plugin_mem_buffer_entry *e =
+        plugin_mem_buffer_entry(buf, cpu_index);
+    size_t n = e->n;
+
+    /* reset first, @buf may be gone once the callback returns */
+    if (n) {
+        e->n = 0;
+        buf->cb(cpu_index, e->records, n, buf->userp);
+    }
+}
+
+/* Called from generated code when the buffer may not fit an insn's accesses */
+void qemu_plugin_mem_buffer_flush_vcpu(uint32_t cpu_index, void *udata)
+{
+    plugin_mem_buffer_drain(udata, cpu_index);
+}
+
+static bool plugin_mem_buffer_is_live(struct qemu_plugin_mem_buffer *buf)
+{
+    struct qemu_plugin_mem_buffer *it;
+    bool found = false;
+
+    qemu_rec_mutex_lock(&plugin.lock);
+    QLIST_FOREACH(it, &plugin.mem_buffers, entry) {
+        if (it == buf) {
+            found = true;
+            break;
+        }
+    }
+    qemu_rec_mutex_unlock(&plugin.lock);
+    return found;
+}
+
+/*
+ * Drain every buffer, for one vCPU or for all of them if @cpu is NULL.
+ *
+ * The callbacks run without plugin.lock and may free buffers, so walk a
+ * snapshot of the list and skip the buffers that are gone by the time
+ * we get to them.
+ */
+static void plugin_mem_buffers_drain_all(CPUState *cpu)
+{
+    g_autoptr(GPtrArray) snapshot = g_ptr_array_new();
+    struct qemu_plugin_mem_buffer *buf;
+
+    qemu_rec_mutex_lock(&plugin.lock);
+    QLIST_FOREACH(buf, &plugin.mem_buffers, entry) {
+        g_ptr_array_add(snapshot, buf);
+    }
+    qemu_rec_mutex_unlock(&plugin.lock);
+
+    for (guint i = 0; i < snapshot->len; i++) {
+        buf = g_ptr_array_index(snapshot, i);
+        if (!cpu) {
+            plugin_mem_buffer_flush(buf);
+        } else if (plugin_mem_buffer_is_live(buf)) {
+            plugin_mem_buffer_drain(buf, cpu->cpu_index);
+        }
+    }
+}
+
 void qemu_plugin_vcpu_exit_hook(CPUState *cpu)
 {
     bool success;
 
+    plugin_mem_buffers_drain_all(cpu);
     plugin_vcpu_cb__simple(cpu, QEMU_PLUGIN_EV_VCPU_EXIT);
 
     assert(cpu->cpu_index != UNASSIGNED_CPU_INDEX);
@@ -346,6 +426,12 @@ static enum plugin_dyn_cb_type op_to_cb_type(enum qemu_plugin_op op)
         return PLUGIN_CB_INLINE_ADD_U64;
     case QEMU_PLUGIN_INLINE_STORE_U64:
         return PLUGIN_CB_INLINE_STORE_U64;
+    case QEMU_PLUGIN_INLINE_MIN_U64:
+        return PLUGIN_CB_INLINE_MIN_U64;
+    case QEMU_PLUGIN_INLINE_MAX_U64:
+        return PLUGIN_CB_INLINE_MAX_U64;
+    case QEMU_PLUGIN_INLINE_OR_U64:
+        return PLUGIN_CB_INLINE_OR_U64;
     default:
         g_assert_not_reached();
     }
@@ -465,6 +551,31 @@ void plugin_register_vcpu_mem_cb(GArray **arr,
     dyn_cb->regular = regular_cb;
 }
 
+void plugin_register_vcpu_mem_buffer(GArray **arr,
+                                     enum qemu_plugin_mem_rw rw,
+                                     struct qemu_plugin_mem_buffer *buf,
+                                     uint64_t pc)
+{
+    static TCGHelperInfo info = {
+        .flags = TCG_CALL_NO_RWG,
+        /*
+         * Match qemu_plugin_mem_buffer_flush_vcpu:
+         *   void (*)(uint32_t, void *)
+         */
+        .typemask = (dh_typemask(void, 0) |
+                     dh_typemask(i32, 1) |
+                     dh_typemask(ptr, 2))
+    };
+
+    struct qemu_plugin_dyn_cb *dyn_cb = plugin_get_dyn_cb(arr);
+    struct qemu_plugin_mem_buffer_cb buffer_cb = { .buf = buf,
+                                                   .info = &info,
+                                                   .pc = pc,
+                                                   .rw = rw };
+    dyn_cb->type = PLUGIN_CB_MEM_BUFFER;
+    dyn_cb->mem_buffer = buffer_cb;
+}
+
 /*
  * Disable CFI checks.
  * The callback function has been loaded from an external library so we do not
@@ -596,11 +707,38 @@ void exec_inline_op(enum plugin_dyn_cb_type type,
     case PLUGIN_CB_INLINE_STORE_U64:
         *val = cb->imm;
         break;
+    case PLUGIN_CB_INLINE_MIN_U64:
+        *val = MIN(*val, cb->imm);
+        break;
+    case PLUGIN_CB_INLINE_MAX_U64:
+        *val = MAX(*val, cb->imm);
+        break;
+    case PLUGIN_CB_INLINE_OR_U64:
+        *val |= cb->imm;
+        break;
     default:
         g_assert_not_reached();
     }
 }
 
+static void exec_mem_buffer_op(struct qemu_plugin_mem_buffer_cb *cb,
+                               int cpu_index, qemu_plugin_meminfo_t meminfo,
+                               uint64_t vaddr)
+{
+    struct qemu_plugin_mem_buffer *buf = cb->buf;
+    struct qemu_plugin_mem_buffer_entry *e =
+        plugin_mem_buffer_entry(buf, cpu_index);
+    qemu_plugin_mem_record *rec;
+
+    if (e->n == buf->n_records) {
+        plugin_mem_buffer_drain(buf, cpu_index);
+    }
+    rec = &e->records[e->n++];
+    rec->vaddr = vaddr;
+    rec->pc = cb->pc;
+    rec->info = meminfo;
+}
+
 void qemu_plugin_vcpu_mem_cb(CPUState *cpu, uint64_t vaddr,
                              uint64_t value_low,
                              uint64_t value_high,
@@ -630,10 +768,19 @@ void qemu_plugin_vcpu_mem_cb(CPUState *cpu, uint64_t vaddr,
             break;
         case PLUGIN_CB_INLINE_ADD_U64:
         case PLUGIN_CB_INLINE_STORE_U64:
+        case PLUGIN_CB_INLINE_MIN_U64:
+        case PLUGIN_CB_INLINE_MAX_U64:
+        case PLUGIN_CB_INLINE_OR_U64:
             if (rw & cb->inline_insn.rw) {
                 exec_inline_op(cb->type, &cb->inline_insn, cpu->cpu_index);
             }
             break;
+        case PLUGIN_CB_MEM_BUFFER:
+            if (rw & cb->mem_buffer.rw) {
+                exec_mem_buffer_op(&cb->mem_buffer, cpu->cpu_index,
+                                   make_plugin_meminfo(oi, rw), vaddr);
+            }
+            break;
         default:
             g_assert_not_reached();
         }
@@ -642,6 +789,9 @@ void qemu_plugin_vcpu_mem_cb(CPUState *cpu, uint64_t vaddr,
 
 void qemu_plugin_atexit_cb(void)
 {
+    /* the plugins expect to have seen every access by now */
+    plugin_mem_buffers_drain_all(NULL);
+
     plugin_cb__udata(QEMU_PLUGIN_EV_ATEXIT);
 }
 
@@ -734,6 +884,7 @@ static void __attribute__((__constructor__)) plugin_init(void)
     plugin.cpu_ht = g_hash_table_new(g_int_hash, g_int_equal);
     QLIST_INIT(&plugin.scoreboards);
     plugin.scoreboard_alloc_size = 16; /* avoid frequent reallocation */
+    QLIST_INIT(&plugin.mem_buffers);
     QTAILQ_INIT(&plugin.ctxs);
     qht_init(&plugin.dyn_cb_arr_ht, plugin_dyn_cb_arr_cmp, 16,
              QHT_MODE_AUTO_RESIZE);
@@ -768,3 +919,58 @@ void plugin_scoreboard_free(struct qemu_plugin_scoreboard *score)
     g_array_free(score->data, TRUE);
     g_free(score);
 }
+
+struct qemu_plugin_mem_buffer *
+plugin_mem_buffer_new(qemu_plugin_id_t id, size_t n_records,
+                      qemu_plugin_vcpu_mem_buffer_cb_t cb, void *udata)
+{
+    struct qemu_plugin_mem_buffer *buf;
+
+    g_assert(n_records > 0);
+    buf = g_new0(struct qemu_plugin_mem_buffer, 1);
+    buf->score = plugin_scoreboard_new(
+        sizeof(struct qemu_plugin_mem_buffer_entry) +
+        n_records * sizeof(qemu_plugin_mem_record));
+    buf->n_records = n_records;
+    buf->cb = cb;
+    buf->userp = udata;
+    buf->id = id;
+
+    qemu_rec_mutex_lock(&plugin.lock);
+    QLIST_INSERT_HEAD(&plugin.mem_buffers, buf, entry);
+    qemu_rec_mutex_unlock(&plugin.lock);
+
+    return buf;
+}
+
+void plugin_mem_buffer_free(struct qemu_plugin_mem_buffer *buf)
+{
+    qemu_rec_mutex_lock(&plugin.lock);
+    QLIST_REMOVE(buf, entry);
+    qemu_rec_mutex_unlock(&plugin.lock);
+
+    plugin_scoreboard_free(buf->score);
+    g_free(buf);
+}
+
+void plugin_mem_buffer_flush(struct qemu_plugin_mem_buffer *buf)
+{
+    for (int i = 0, n = plugin.num_vcpus; i < n; i++) {
+        if (!plugin_mem_buffer_is_live(buf)) {
+            break;
+        }
+        plugin_mem_buffer_drain(buf, i);
+    }
+}
+
+/* The buffers of an uninstalled plugin must not call back into it */
+void plugin_mem_buffers_free__locked(qemu_plugin_id_t id)
+{
+    struct qemu_plugin_mem_buffer *buf, *next;
+
+    QLIST_FOREACH_SAFE(buf, &plugin.mem_buffers, entry, next) {
+        if (buf->id == id) {
+            plugin_mem_buffer_free(buf);
+        }
+    }
+}
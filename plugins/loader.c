@@ -361,6 +361,7 @@ static void plugin_reset_destroy__locked(struct qemu_plugin_reset_data *data)
         abort();
     }
 
+    plugin_mem_buffers_free__locked(ctx->id);
     success = g_hash_table_remove(plugin.id_ht, &ctx->id);
     g_assert(success);
     QTAILQ_REMOVE(&plugin.ctxs, ctx, entry);
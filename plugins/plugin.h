@@ -33,6 +33,7 @@ struct qemu_plugin_state {
     GHashTable *cpu_ht;
     QLIST_HEAD(, qemu_plugin_scoreboard) scoreboards;
     size_t scoreboard_alloc_size;
+    QLIST_HEAD(, qemu_plugin_mem_buffer) mem_buffers;
     DECLARE_BITMAP(mask, QEMU_PLUGIN_EV_MAX);
     /*
      * @lock protects the struct as well as ctx->uninstalling.
@@ -108,6 +109,11 @@ void plugin_register_vcpu_mem_cb(GArray **arr,
                                  enum qemu_plugin_mem_rw rw,
                                  void *udata);
 
+void plugin_register_vcpu_mem_buffer(GArray **arr,
+                                     enum qemu_plugin_mem_rw rw,
+                                     struct qemu_plugin_mem_buffer *buf,
+                                     uint64_t pc);
+
 void exec_inline_op(enum plugin_dyn_cb_type type,
                     struct qemu_plugin_inline_cb *cb,
                     int cpu_index);
@@ -118,4 +124,14 @@ struct qemu_plugin_scoreboard *plugin_scoreboard_new(size_t element_size);
 
 void plugin_scoreboard_free(struct qemu_plugin_scoreboard *score);
 
+struct qemu_plugin_mem_buffer *
+plugin_mem_buffer_new(qemu_plugin_id_t id, size_t n_records,
+                      qemu_plugin_vcpu_mem_buffer_cb_t cb, void *udata);
+
+void plugin_mem_buffer_free(struct qemu_plugin_mem_buffer *buf);
+
+void plugin_mem_buffer_flush(struct qemu_plugin_mem_buffer *buf);
+
+void plugin_mem_buffers_free__locked(qemu_plugin_id_t id);
+
 #endif /* PLUGIN_H */
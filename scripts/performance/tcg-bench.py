@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+
+#  Measure the throughput of the TCG translation and execution pipeline
+#  for one linux-user run, and print the result as JSON.
+#
+#  Syntax:
+#  tcg-bench.py [-h] [-r REPEAT] [-p PLUGIN] -- <qemu executable> \
+#               [<qemu executable options>] <target executable> \
+#               [<target executable options>]
+#
+#  [-h] - Print the script arguments help message.
+#  [-r] - Number of timed runs; the fastest one is reported.
+#  [-p] - Path to tests/tcg/plugins/libinsn.so.  If given, one extra
+#         run counts the executed guest instructions, which is needed
+#         to report the execution speed in MIPS.
+#
+#  Example of usage, using the test programs built by "make check-tcg":
+#  tcg-bench.py -p build/tests/tcg/plugins/libinsn.so -- \
+#      build/qemu-x86_64 build/tests/tcg/x86_64-linux-user/sha512
+#  tcg-bench.py -p build/tests/tcg/plugins/libinsn.so -- \
+#      build/qemu-aarch64 build/tests/tcg/aarch64-linux-user/sha512
+#  tcg-bench.py -p build/tests/tcg/plugins/libinsn.so -- \
+#      build/qemu-riscv64 build/tests/tcg/riscv64-linux-user/sha512
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def run_qemu(command, log_items, extra_args):
+    """
+    Run QEMU once, logging LOG_ITEMS to a temporary file.
+
+    Parameters:
+    command (list): QEMU executable followed by its arguments
+    log_items (str): argument of the -d option
+    extra_args (list): options inserted after the QEMU executable
+
+    Returns:
+    (int, list): wall time in ns, lines of the log file
+    """
+    with tempfile.TemporaryDirectory() as tmpdir:
+        log_path = os.path.join(tmpdir, "qemu.log")
+        qemu_command = [command[0], "-d", log_items, "-D", log_path] + \
+            extra_args + command[1:]
+
+        start = time.perf_counter_ns()
+        run = subprocess.run(qemu_command, stdout=subprocess.DEVNULL)
+        wall_time = time.perf_counter_ns() - start
+        if run.returncode:
+            sys.exit("Command failed with exit code {}: {}".format(
+                run.returncode, " ".join(qemu_command)))
+
+        with open(log_path, "r") as log:
+            return wall_time, log.readlines()
+
+
+def parse_stats(lines):
+    """
+    Parse the "name  value" lines printed by -d tb_stats.
+
+    Parameters:
+    lines (list): lines of the QEMU log
+
+    Returns:
+    (dict): statistic name to integer value
+    """
+    stats = {}
+    for line in lines:
+        match = re.match(r"^(\S.*?)\s{2,}(\d+)", line)
+        if match:
+            stats[match.group(1)] = int(match.group(2))
+    return stats
+
+
+def parse_insns(lines):
+    """
+    Parse the total printed by the insn plugin.
+
+    Parameters:
+    lines (list): lines of the QEMU log
+
+    Returns:
+    (int): number of executed guest instructions
+    """
+    for line in lines:
+        match = re.match(r"^total insns: (\d+)", line)
+        if match:
+            return int(match.group(1))
+    sys.exit("Couldn't find the insn plugin output ... Exiting.")
+
+
+def ratio(num, den):
+    return num / den if den else None
+
+
+def main():
+    # Parse the command line arguments
+    parser = argparse.ArgumentParser(
+        usage='tcg-bench.py [-h] [-r REPEAT] [-p PLUGIN] -- '
+        '<qemu executable> [<qemu executable options>] '
+        '<target executable> [<target executable options>]')
+
+    parser.add_argument('-r', '--repeat', type=int, default=3,
+                        help='number of timed runs (default: 3)')
+    parser.add_argument('-p', '--plugin', type=str,
+                        help='path to libinsn.so, to count executed insns')
+    parser.add_argument('command', type=str, nargs='+', help=argparse.SUPPRESS)
+
+    args = parser.parse_args()
+
+    # Keep the fastest of the timed runs
+    best = None
+    for _ in range(max(args.repeat, 1)):
+        wall_time, lines = run_qemu(args.command, "tb_stats", [])
+        if best is None or wall_time < best[0]:
+            best = (wall_time, lines)
+    wall_time, stats = best[0], parse_stats(best[1])
+    if "translations" not in stats:
+        sys.exit("QEMU does not support -d tb_stats ... Exiting.")
+
+    trans_time = stats["translation time"]
+    guest_insns = stats["guest insns"]
+    result = {
+        "command": args.command,
+        "wall_time_ns": wall_time,
+        "translations": stats["translations"],
+        "translations_lost": stats["translations lost"],
+        "translated_guest_insns": guest_insns,
+        "translation_time_ns": trans_time,
+        "translation_ns_per_guest_insn": ratio(trans_time, guest_insns),
+        "host_bytes_per_guest_insn": ratio(stats["host code bytes"],
+                                           guest_insns),
+        "optimizer_time_ns": stats["optimizer time"],
+        "tcg_ops": stats["ops allocated"],
+        "temp_loads": stats["temp loads"],
+        "temp_stores": stats["temp stores"],
+        "flushes": stats["flushes"],
+        "executed_guest_insns": None,
+        "exec_mips": None,
+    }
+
+    # Count executed instructions in a separate, untimed, run
+    if args.plugin:
+        _, lines = run_qemu(args.command, "plugin",
+                            ["-plugin", args.plugin + ",inline=on"])
+        executed = parse_insns(lines)
+        result["executed_guest_insns"] = executed
+        exec_time = wall_time - trans_time
+        if exec_time > 0:
+            result["exec_mips"] = executed * 1000 / exec_time
+
+    json.dump(result, sys.stdout, indent=2)
+    print()
+
+
+if __name__ == "__main__":
+    main()
@@ -158,19 +158,44 @@ LOGICAL_PPPP(sve_nand_pppp, DO_NAND)
 #undef DO_SEL
 #undef LOGICAL_PPPP
 
+/*
+ * Return the end of the run of 16-byte chunks, starting at byte offset I
+ * and ending at most at OPR_SZ, in which every element of size ESZ is
+ * active.  Within such a run the expanders below need not test the
+ * predicate, which lets the compiler vectorize the operation: with
+ * the common all-true predicate that is the whole vector.
+ */
+static inline intptr_t pred_active_run(void *vg, intptr_t i,
+                                       intptr_t opr_sz, int esz)
+{
+    uint16_t mask = pred_esz_masks[esz];
+
+    while (i < opr_sz && (*(uint16_t *)(vg + H1_2(i >> 3)) & mask) == mask) {
+        i += 16;
+    }
+    return i;
+}
+
 /* Fully general three-operand expander, controlled by a predicate.
  * This is complicated by the host-endian storage of the register file.
- */
-/* ??? I don't expect the compiler could ever vectorize this itself.
- * With some tables we can convert bit masks to byte masks, and with
- * extra care wrt byte/word ordering we could use gcc generic vectors
- * and do 16 bytes at a time.
+ * Runs of active elements are handled without testing the predicate;
+ * a partially active 16-byte chunk falls back to testing each element.
  */
 #define DO_ZPZZ(NAME, TYPE, H, OP)                                       \
 void HELPER(NAME)(void *vd, void *vn, void *vm, void *vg, uint32_t desc) \
 {                                                                       \
     intptr_t i, opr_sz = simd_oprsz(desc);                              \
     for (i = 0; i < opr_sz; ) {                                         \
+        intptr_t end = pred_active_run(vg, i, opr_sz,                   \
+                                       ctz32(sizeof(TYPE)));            \
+        if (end > i) {                                                  \
+            for (; i < end; i += sizeof(TYPE)) {                        \
+                TYPE nn = *(TYPE *)(vn + H(i));                         \
+                TYPE mm = *(TYPE *)(vm + H(i));                         \
+                *(TYPE *)(vd + H(i)) = OP(nn, mm);                      \
+            }                                                           \
+            continue;                                                   \
+        }                                                               \
         uint16_t pg = *(uint16_t *)(vg + H1_2(i >> 3));                 \
         do {                                                            \
             if (pg & 1) {                                               \
@@ -190,10 +215,21 @@ void HELPER(NAME)(void *vd, void *vn, void *vm, void *vg, uint32_t desc) \
     intptr_t i, opr_sz = simd_oprsz(desc) / 8;                  \
     TYPE *d = vd, *n = vn, *m = vm;                             \
     uint8_t *pg = vg;                                           \
-    for (i = 0; i < opr_sz; i += 1) {                           \
-        if (pg[H1(i)] & 1) {                                    \
-            TYPE nn = n[i], mm = m[i];                          \
-            d[i] = OP(nn, mm);                                  \
+    for (i = 0; i < opr_sz; ) {                                 \
+        intptr_t end = pred_active_run(vg, i * 8, opr_sz * 8,   \
+                                       MO_64) / 8;              \
+        if (end > i) {                                          \
+            for (; i < end; i += 1) {                           \
+                TYPE nn = n[i], mm = m[i];                      \
+                d[i] = OP(nn, mm);                              \
+            }                                                   \
+            continue;                                           \
+        }                                                       \
+        for (end = MIN(i + 2, opr_sz); i < end; i += 1) {       \
+            if (pg[H1(i)] & 1) {                                \
+                TYPE nn = n[i], mm = m[i];                      \
+                d[i] = OP(nn, mm);                              \
+            }                                                   \
         }                                                       \
     }                                                           \
 }
@@ -819,6 +855,15 @@ void HELPER(NAME)(void *vd, void *vn, void *vg, uint32_t desc)  \
 {                                                               \
     intptr_t i, opr_sz = simd_oprsz(desc);                      \
     for (i = 0; i < opr_sz; ) {                                 \
+        intptr_t end = pred_active_run(vg, i, opr_sz,           \
+                                       ctz32(sizeof(TYPE)));    \
+        if (end > i) {                                          \
+            for (; i < end; i += sizeof(TYPE)) {                \
+                TYPE nn = *(TYPE *)(vn + H(i));                 \
+                *(TYPE *)(vd + H(i)) = OP(nn);                  \
+            }                                                   \
+            continue;                                           \
+        }                                                       \
         uint16_t pg = *(uint16_t *)(vg + H1_2(i >> 3));         \
         do {                                                    \
             if (pg & 1) {                                       \
@@ -837,10 +882,21 @@ void HELPER(NAME)(void *vd, void *vn, void *vg, uint32_t desc)  \
     intptr_t i, opr_sz = simd_oprsz(desc) / 8;                  \
     TYPE *d = vd, *n = vn;                                      \
     uint8_t *pg = vg;                                           \
-    for (i = 0; i < opr_sz; i += 1) {                           \
-        if (pg[H1(i)] & 1) {                                    \
-            TYPE nn = n[i];                                     \
-            d[i] = OP(nn);                                      \
+    for (i = 0; i < opr_sz; ) {                                 \
+        intptr_t end = pred_active_run(vg, i * 8, opr_sz * 8,   \
+                                       MO_64) / 8;              \
+        if (end > i) {                                          \
+            for (; i < end; i += 1) {                           \
+                TYPE nn = n[i];                                 \
+                d[i] = OP(nn);                                  \
+            }                                                   \
+            continue;                                           \
+        }                                                       \
+        for (end = MIN(i + 2, opr_sz); i < end; i += 1) {       \
+            if (pg[H1(i)] & 1) {                                \
+                TYPE nn = n[i];                                 \
+                d[i] = OP(nn);                                  \
+            }                                                   \
         }                                                       \
     }                                                           \
 }
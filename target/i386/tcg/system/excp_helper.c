@@ -37,6 +37,7 @@ typedef struct TranslateResult {
     hwaddr paddr;
     int prot;
     int page_size;
+    int map_size;
 } TranslateResult;
 
 typedef enum TranslateFaultStage2 {
@@ -152,7 +153,7 @@ static bool mmu_translate(CPUX86State *env, const TranslateParams *in,
     };
     hwaddr pte_addr, paddr;
     uint32_t pkr;
-    int page_size;
+    int page_size, map_size;
     int error_code;
     int prot;
 
@@ -440,6 +441,7 @@ do_check_protect_pse36:
      * Note that NPT is walked (for both paging structures and final guest
      * addresses) using the address with the A20 bit set.
      */
+    map_size = page_size;
     if (in->ptw_idx == MMU_NESTED_IDX) {
         CPUTLBEntryFull *full;
         int flags, nested_page_size;
@@ -475,11 +477,14 @@ do_check_protect_pse36:
         if (nested_page_size > page_size) {
             page_size = nested_page_size;
         }
+        /* ... but only the smaller of the two is mapped contiguously. */
+        map_size = MIN(map_size, nested_page_size);
     }
 
     out->paddr = paddr & x86_get_a20_mask(env);
     out->prot = prot;
     out->page_size = page_size;
+    out->map_size = map_size;
     return true;
 
  do_fault_rsvd:
@@ -603,6 +608,7 @@ static bool get_physical_address(CPUX86State *env, vaddr addr,
     out->paddr = addr & x86_get_a20_mask(env);
     out->prot = PAGE_READ | PAGE_WRITE | PAGE_EXEC;
     out->page_size = TARGET_PAGE_SIZE;
+    out->map_size = TARGET_PAGE_SIZE;
     return true;
 }
 
@@ -618,13 +624,22 @@ bool x86_cpu_tlb_fill(CPUState *cs, vaddr addr, int size,
                              retaddr)) {
         /*
          * Even if 4MB pages, we map only one 4KB page in the cache to
-         * avoid filling it too fast.
+         * avoid filling it too fast.  Report the size of the mapping so
+         * that the other pages can be filled without another walk, unless
+         * the A20 mask breaks it up.
          */
+        CPUTLBEntryFull full = {
+            .phys_addr = out.paddr & TARGET_PAGE_MASK,
+            .attrs = cpu_get_mem_attrs(env),
+            .prot = out.prot,
+            .lg_page_size = ctz32(out.page_size),
+        };
+
+        if (x86_get_a20_mask(env) == -1) {
+            full.lg_map_size = ctz32(out.map_size);
+        }
         assert(out.prot & (1 << access_type));
-        tlb_set_page_with_attrs(cs, addr & TARGET_PAGE_MASK,
-                                out.paddr & TARGET_PAGE_MASK,
-                                cpu_get_mem_attrs(env),
-                                out.prot, mmu_idx, out.page_size);
+        tlb_set_page_full(cs, mmu_idx, addr & TARGET_PAGE_MASK, &full);
         return true;
     }
 
@@ -57,6 +57,9 @@ struct tcg_region_tree {
  * dynamically allocate from as demand dictates. Given appropriate region
  * sizing, this minimizes flushes even when some TCG threads generate a lot
  * more code than others.
+ *
+ * Once every region has been handed out, the oldest full regions can be
+ * recycled with tcg_region_evict() instead of flushing the whole buffer.
  */
 struct tcg_region_state {
     QemuMutex lock;
@@ -72,6 +75,11 @@ struct tcg_region_state {
     /* fields protected by the lock */
     size_t current; /* current region index */
     size_t agg_size_full; /* aggregate size of full regions */
+    size_t *full; /* ring of full region indexes, oldest first */
+    size_t full_head;
+    size_t n_full;
+    size_t *free; /* stack of evicted region indexes */
+    size_t n_free;
 };
 
 static struct tcg_region_state region;
@@ -191,10 +199,23 @@ static void tcg_region_trees_init(void)
     }
 }
 
-static struct tcg_region_tree *tc_ptr_to_region_tree(const void *p)
+/* Return the index of the region containing @p, in the rw buffer. */
+static size_t tcg_region_index(const void *p)
 {
-    size_t region_idx;
+    ptrdiff_t offset;
+
+    if (p < region.start_aligned) {
+        return 0;
+    }
+    offset = p - region.start_aligned;
+    if (offset > region.stride * (region.n - 1)) {
+        return region.n - 1;
+    }
+    return offset / region.stride;
+}
 
+static struct tcg_region_tree *tc_ptr_to_region_tree(const void *p)
+{
     /*
      * Like tcg_splitwx_to_rw, with no assert.  The pc may come from
      * a signal handler over which the caller has no control.
@@ -205,19 +226,7 @@ static struct tcg_region_tree *tc_ptr_to_region_tree(const void *p)
             return NULL;
         }
     }
-
-    if (p < region.start_aligned) {
-        region_idx = 0;
-    } else {
-        ptrdiff_t offset = p - region.start_aligned;
-
-        if (offset > region.stride * (region.n - 1)) {
-            region_idx = region.n - 1;
-        } else {
-            region_idx = offset / region.stride;
-        }
-    }
-    return region_trees + region_idx * tree_size;
+    return region_trees + tcg_region_index(p) * tree_size;
 }
 
 void tcg_tb_insert(TranslationBlock *tb)
@@ -359,6 +368,10 @@ static void tcg_region_assign(TCGContext *s, size_t curr_region)
 
 static bool tcg_region_alloc__locked(TCGContext *s)
 {
+    if (region.n_free) {
+        tcg_region_assign(s, region.free[--region.n_free]);
+        return false;
+    }
     if (region.current == region.n) {
         return true;
     }
@@ -374,13 +387,16 @@ static bool tcg_region_alloc__locked(TCGContext *s)
 bool tcg_region_alloc(TCGContext *s)
 {
     bool err;
-    /* read the region size now; alloc__locked will overwrite it on success */
+    /* read the region now; alloc__locked will overwrite it on success */
     size_t size_full = s->code_gen_buffer_size;
+    size_t idx_full = tcg_region_index(s->code_gen_buffer);
 
     qemu_mutex_lock(&region.lock);
     err = tcg_region_alloc__locked(s);
     if (!err) {
         region.agg_size_full += size_full - TCG_HIGHWATER;
+        region.full[(region.full_head + region.n_full) % region.n] = idx_full;
+        region.n_full++;
     }
     qemu_mutex_unlock(&region.lock);
     return err;
@@ -412,6 +428,9 @@ void tcg_region_reset_all(void)
     qemu_mutex_lock(&region.lock);
     region.current = 0;
     region.agg_size_full = 0;
+    region.full_head = 0;
+    region.n_full = 0;
+    region.n_free = 0;
 
     for (i = 0; i < n_ctxs; i++) {
         TCGContext *s = qatomic_read(&tcg_ctxs[i]);
@@ -422,10 +441,80 @@ void tcg_region_reset_all(void)
     tcg_region_tree_reset_all();
 }
 
+static gboolean tcg_region_collect_tb(gpointer key, gpointer value,
+                                      gpointer data)
+{
+    g_ptr_array_add(data, value);
+    return false;
+}
+
+/*
+ * Recycle the oldest half of the full regions: call @evict_tb on each
+ * TB they contain, then make them available to tcg_region_alloc again.
+ * Regions currently assigned to a context are never recycled.
+ * Returns false, without evicting anything, if there is no full region.
+ *
+ * Call from a safe-work context.
+ */
+bool tcg_region_evict(void (*evict_tb)(TranslationBlock *tb))
+{
+    g_autoptr(GPtrArray) tbs = g_ptr_array_new();
+    size_t i, n_evict;
+
+    qemu_mutex_lock(&region.lock);
+    n_evict = DIV_ROUND_UP(region.n_full, 2);
+    if (n_evict == 0) {
+        qemu_mutex_unlock(&region.lock);
+        return false;
+    }
+
+    for (i = 0; i < n_evict; i++) {
+        size_t r = region.full[(region.full_head + i) % region.n];
+        struct tcg_region_tree *rt = region_trees + r * tree_size;
+
+        qemu_mutex_lock(&rt->lock);
+        q_tree_foreach(rt->tree, tcg_region_collect_tb, tbs);
+        qemu_mutex_unlock(&rt->lock);
+    }
+
+    for (i = 0; i < tbs->len; i++) {
+        evict_tb(g_ptr_array_index(tbs, i));
+    }
+
+    for (i = 0; i < n_evict; i++) {
+        size_t r = region.full[region.full_head];
+        struct tcg_region_tree *rt = region_trees + r * tree_size;
+        void *start, *end;
+
+        qemu_mutex_lock(&rt->lock);
+        /* Increment the refcount first so that destroy acts as a reset */
+        q_tree_ref(rt->tree);
+        q_tree_destroy(rt->tree);
+        qemu_mutex_unlock(&rt->lock);
+
+        tcg_region_bounds(r, &start, &end);
+        region.agg_size_full -= end - start - TCG_HIGHWATER;
+        region.free[region.n_free++] = r;
+        region.full_head = (region.full_head + 1) % region.n;
+        region.n_full--;
+    }
+    qemu_mutex_unlock(&region.lock);
+    return true;
+}
+
+/*
+ * With a single context, still split the buffer in a few large regions
+ * so that tcg_region_evict() has something to recycle.
+ */
+static size_t tcg_n_regions_single(size_t tb_size)
+{
+    return MAX(1, MIN(tb_size / (16 * MiB), 8));
+}
+
 static size_t tcg_n_regions(size_t tb_size, unsigned max_cpus)
 {
 #ifdef CONFIG_USER_ONLY
-    return 1;
+    return tcg_n_regions_single(tb_size);
 #else
     size_t n_regions;
 
@@ -435,9 +524,9 @@ static size_t tcg_n_regions(size_t tb_size, unsigned max_cpus)
      * being of reasonable size. If that's not possible we make do by evenly
      * dividing the code_gen_buffer among the vCPUs.
      */
-    /* Use a single region if all we have is one vCPU thread */
+    /* Use a single context if all we have is one vCPU thread */
     if (max_cpus == 1 || !qemu_tcg_mttcg_enabled()) {
-        return 1;
+        return tcg_n_regions_single(tb_size);
     }
 
     /*
@@ -808,6 +897,8 @@ void tcg_region_init(size_t tb_size, int splitwx, unsigned max_cpus)
 
     /* init the region struct */
     qemu_mutex_init(&region.lock);
+    region.full = g_new(size_t, region.n);
+    region.free = g_new(size_t, region.n);
 
     /*
      * Set guard pages in the rw buffer, as that's the one into which
@@ -3285,6 +3285,48 @@ static void move_label_uses(TCGLabel *to, TCGLabel *from)
     QSIMPLEQ_CONCAT(&to->branches, &from->branches);
 }
 
+/*
+ * Return true if any op in the TB uses TSTEQ or TSTNE, which the
+ * optimizer must lower for backends without TCG_TARGET_HAS_tst.
+ */
+static bool tcg_has_tst_cond(TCGContext *s)
+{
+    TCGOp *op;
+
+    QTAILQ_FOREACH(op, &s->ops, link) {
+        TCGCond cond;
+
+        switch (op->opc) {
+        case INDEX_op_brcond_i32:
+        case INDEX_op_brcond_i64:
+            cond = op->args[2];
+            break;
+        case INDEX_op_setcond_i32:
+        case INDEX_op_setcond_i64:
+        case INDEX_op_negsetcond_i32:
+        case INDEX_op_negsetcond_i64:
+        case INDEX_op_cmp_vec:
+            cond = op->args[3];
+            break;
+        case INDEX_op_brcond2_i32:
+            cond = op->args[4];
+            break;
+        case INDEX_op_movcond_i32:
+        case INDEX_op_movcond_i64:
+        case INDEX_op_setcond2_i32:
+        case INDEX_op_cmpsel_vec:
+            cond = op->args[5];
+            break;
+        default:
+            continue;
+        }
+        if (is_tst_cond(cond)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /* Reachable analysis : remove unreachable code.  */
 static void __attribute__((noinline))
 reachable_code_pass(TCGContext *s)
@@ -3457,6 +3499,44 @@ static void la_global_sync(TCGContext *s, int ng)
     }
 }
 
+/*
+ * liveness analysis: label: as for the end of a basic block, except that
+ * direct globals only need to be synced, so that the register allocator
+ * may keep them in registers across the label.  Indirect globals are
+ * replaced by TEMP_EBB temps in liveness_pass_2, which must be reloaded
+ * after the label: keep them dead there.
+ */
+static void la_label(TCGContext *s, int ng, int nt)
+{
+    la_global_sync(s, ng);
+
+    for (int i = 0; i < ng; ++i) {
+        TCGTemp *ts = &s->temps[i];
+
+        if (ts->indirect_reg) {
+            ts->state = TS_DEAD | TS_MEM;
+            la_reset_pref(ts);
+        }
+    }
+
+    for (int i = ng; i < nt; ++i) {
+        TCGTemp *ts = &s->temps[i];
+
+        switch (ts->kind) {
+        case TEMP_TB:
+            ts->state = TS_DEAD | TS_MEM;
+            break;
+        case TEMP_EBB:
+        case TEMP_CONST:
+            ts->state = TS_DEAD;
+            break;
+        default:
+            g_assert_not_reached();
+        }
+        la_reset_pref(ts);
+    }
+}
+
 /*
  * liveness analysis: conditional branch: all temps are dead unless
  * explicitly live-across-conditional-branch, globals and local temps
@@ -3863,6 +3943,8 @@ liveness_pass_1(TCGContext *s)
             /* If end of basic block, update.  */
             if (def->flags & TCG_OPF_BB_EXIT) {
                 la_func_end(s, nb_globals, nb_temps);
+            } else if (opc == INDEX_op_set_label) {
+                la_label(s, nb_globals, nb_temps);
             } else if (def->flags & TCG_OPF_COND_BRANCH) {
                 la_bb_sync(s, nb_globals, nb_temps);
             } else if (def->flags & TCG_OPF_BB_END) {
@@ -4272,6 +4354,7 @@ static void temp_sync(TCGContext *s, TCGTemp *ts, TCGRegSet allocated_regs,
             if (free_or_dead
                 && tcg_out_sti(s, ts->type, ts->val,
                                ts->mem_base->reg, ts->mem_offset)) {
+                qatomic_set(&s->stat_temp_stores, s->stat_temp_stores + 1);
                 break;
             }
             temp_load(s, ts, tcg_target_available_regs[ts->type],
@@ -4281,6 +4364,7 @@ static void temp_sync(TCGContext *s, TCGTemp *ts, TCGRegSet allocated_regs,
         case TEMP_VAL_REG:
             tcg_out_st(s, ts->type, ts->reg,
                        ts->mem_base->reg, ts->mem_offset);
+            qatomic_set(&s->stat_temp_stores, s->stat_temp_stores + 1);
             break;
 
         case TEMP_VAL_MEM:
@@ -4464,6 +4548,7 @@ static void temp_load(TCGContext *s, TCGTemp *ts, TCGRegSet desired_regs,
         reg = tcg_reg_alloc(s, desired_regs, allocated_regs,
                             preferred_regs, ts->indirect_base);
         tcg_out_ld(s, ts->type, reg, ts->mem_base->reg, ts->mem_offset);
+        qatomic_set(&s->stat_temp_loads, s->stat_temp_loads + 1);
         ts->mem_coherent = 1;
         break;
     case TEMP_VAL_DEAD:
@@ -4567,6 +4652,85 @@ static void tcg_reg_alloc_cbranch(TCGContext *s, TCGRegSet allocated_regs)
     }
 }
 
+/*
+ * After a branch to @l, record which globals are in registers (and in sync
+ * with memory).  For a label with several branches, keep only the globals
+ * that are in the same register on all of them.
+ */
+static void tcg_reg_alloc_branch(TCGContext *s, TCGLabel *l)
+{
+    TCGTemp **entry = l->entry_regs;
+
+    if (l->has_value) {
+        /* Backward branch: the code at the label is already generated. */
+        return;
+    }
+    if (entry == NULL) {
+        entry = l->entry_regs = tcg_malloc(sizeof(TCGTemp *)
+                                           * TCG_TARGET_NB_REGS);
+        memcpy(entry, s->reg_to_temp, sizeof(TCGTemp *) * TCG_TARGET_NB_REGS);
+    }
+    for (int i = 0; i < TCG_TARGET_NB_REGS; i++) {
+        TCGTemp *ts = s->reg_to_temp[i];
+
+        if (entry[i] != ts || ts == NULL ||
+            ts->kind != TEMP_GLOBAL || !ts->mem_coherent) {
+            entry[i] = NULL;
+        }
+    }
+    l->nb_entry_branches++;
+}
+
+/*
+ * At a label, all temporaries are dead and globals are in memory, as at
+ * the end of a basic block.  However, if all branches to the label have
+ * been seen, a global may stay in a register that holds it on every one
+ * of them as well as on the fall through.
+ */
+static void tcg_reg_alloc_label(TCGContext *s, TCGLabel *l)
+{
+    TCGLabelUse *u;
+    unsigned nb_branches = 0;
+    bool keep;
+
+    QSIMPLEQ_FOREACH(u, &l->branches, next) {
+        nb_branches++;
+    }
+    keep = l->nb_entry_branches == nb_branches;
+
+    for (int i = 0; i < s->nb_globals; i++) {
+        TCGTemp *ts = &s->temps[i];
+
+        if (ts->kind == TEMP_FIXED) {
+            continue;
+        }
+        if (keep && ts->val_type == TEMP_VAL_REG &&
+            (l->entry_regs == NULL || l->entry_regs[ts->reg] == ts)) {
+            qatomic_set(&s->stat_label_kept, s->stat_label_kept + 1);
+            continue;
+        }
+        temp_sync(s, ts, s->reserved_regs, 0, -1);
+    }
+
+    for (int i = s->nb_globals; i < s->nb_temps; i++) {
+        TCGTemp *ts = &s->temps[i];
+
+        switch (ts->kind) {
+        case TEMP_TB:
+            temp_save(s, ts, s->reserved_regs);
+            break;
+        case TEMP_EBB:
+            tcg_debug_assert(ts->val_type == TEMP_VAL_DEAD);
+            break;
+        case TEMP_CONST:
+            tcg_debug_assert(ts->val_type == TEMP_VAL_CONST);
+            break;
+        default:
+            g_assert_not_reached();
+        }
+    }
+}
+
 /*
  * Specialized code generation for INDEX_op_mov_* with a constant.
  */
@@ -5058,8 +5222,12 @@ static void tcg_reg_alloc_op(TCGContext *s, const TCGOp *op)
 
     if (def->flags & TCG_OPF_COND_BRANCH) {
         tcg_reg_alloc_cbranch(s, i_allocated_regs);
+        tcg_reg_alloc_branch(s, arg_label(op->args[nb_oargs + nb_iargs + 1]));
     } else if (def->flags & TCG_OPF_BB_END) {
         tcg_reg_alloc_bb_end(s, i_allocated_regs);
+        if (op->opc == INDEX_op_br) {
+            tcg_reg_alloc_branch(s, arg_label(op->args[0]));
+        }
     } else {
         if (def->flags & TCG_OPF_CALL_CLOBBER) {
             /* XXX: permit generic clobber register list ? */
@@ -6123,7 +6291,19 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb, uint64_t pc_start)
     /* Do not reuse any EBB that may be allocated within the TB. */
     tcg_temp_ebb_reset_freed(s);
 
-    tcg_optimize(s);
+    /*
+     * For a block that runs once the optimizer costs more than it can
+     * possibly save, but it is also where TSTEQ and TSTNE are lowered
+     * for backends without TCG_TARGET_HAS_tst, so it must still run
+     * whenever such a condition is present.
+     */
+    if (!s->skip_optimize ||
+        (!TCG_TARGET_HAS_tst && tcg_has_tst_cond(s))) {
+        int64_t ti = get_clock();
+
+        tcg_optimize(s);
+        stat64_add(&s->stat_opt_time_ns, get_clock() - ti);
+    }
 
     reachable_code_pass(s);
     liveness_pass_0(s);
@@ -6193,6 +6373,8 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb, uint64_t pc_start)
     QTAILQ_FOREACH(op, &s->ops, link) {
         TCGOpcode opc = op->opc;
 
+        qatomic_set(&s->stat_ops, s->stat_ops + 1);
+
         switch (opc) {
         case INDEX_op_mov_i32:
         case INDEX_op_mov_i64:
@@ -6219,7 +6401,7 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb, uint64_t pc_start)
             temp_dead(s, arg_temp(op->args[0]));
             break;
         case INDEX_op_set_label:
-            tcg_reg_alloc_bb_end(s, s->reserved_regs);
+            tcg_reg_alloc_label(s, arg_label(op->args[0]));
             tcg_out_label(s, arg_label(op->args[0]));
             break;
         case INDEX_op_call:
@@ -6287,6 +6469,32 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb, uint64_t pc_start)
     return tcg_current_code_size(s);
 }
 
+void tcg_dump_op_count(GString *buf)
+{
+    unsigned int n_ctxs = qatomic_read(&tcg_cur_ctxs);
+    size_t ops = 0, loads = 0, stores = 0, kept = 0;
+    uint64_t opt_time = 0;
+
+    for (unsigned int i = 0; i < n_ctxs; i++) {
+        const TCGContext *s = qatomic_read(&tcg_ctxs[i]);
+
+        opt_time += stat64_get(&s->stat_opt_time_ns);
+        ops += qatomic_read(&s->stat_ops);
+        loads += qatomic_read(&s->stat_temp_loads);
+        stores += qatomic_read(&s->stat_temp_stores);
+        kept += qatomic_read(&s->stat_label_kept);
+    }
+
+    g_string_append_printf(buf, "ops allocated       %zu\n", ops);
+    g_string_append_printf(buf, "temp loads          %zu (%0.2f/op)\n",
+                           loads, ops ? (double)loads / ops : 0);
+    g_string_append_printf(buf, "temp stores         %zu (%0.2f/op)\n",
+                           stores, ops ? (double)stores / ops : 0);
+    g_string_append_printf(buf, "label-kept globals  %zu\n", kept);
+    g_string_append_printf(buf, "optimizer time      %" PRIu64 " ns\n",
+                           opt_time);
+}
+
 #ifdef ELF_HOST_MACHINE
 /* In order to use this feature, the backend needs to do three things:
 
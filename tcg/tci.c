@@ -91,6 +91,15 @@ static void tci_args_rl(uint32_t insn, const void *tb_ptr,
     *l1 = sextract32(insn, 12, 20) + (void *)tb_ptr;
 }
 
+static void tci_args_rrcl(uint32_t insn, const uint32_t *tb_ptr,
+                          TCGReg *r0, TCGReg *r1, TCGCond *c2, void **l3)
+{
+    *r0 = extract32(insn, 8, 4);
+    *r1 = extract32(insn, 12, 4);
+    *c2 = extract32(insn, 16, 4);
+    *l3 = (int32_t)*tb_ptr + (void *)(tb_ptr + 1);
+}
+
 static void tci_args_rr(uint32_t insn, TCGReg *r0, TCGReg *r1)
 {
     *r0 = extract32(insn, 8, 4);
@@ -669,8 +678,9 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             break;
 #endif
         case INDEX_op_brcond_i32:
-            tci_args_rl(insn, tb_ptr, &r0, &ptr);
-            if ((uint32_t)regs[r0]) {
+            tci_args_rrcl(insn, tb_ptr, &r0, &r1, &condition, &ptr);
+            tb_ptr++;
+            if (tci_compare32(regs[r0], regs[r1], condition)) {
                 tb_ptr = ptr;
             }
             break;
@@ -880,8 +890,9 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             break;
 #endif
         case INDEX_op_brcond_i64:
-            tci_args_rl(insn, tb_ptr, &r0, &ptr);
-            if (regs[r0]) {
+            tci_args_rrcl(insn, tb_ptr, &r0, &r1, &condition, &ptr);
+            tb_ptr++;
+            if (tci_compare64(regs[r0], regs[r1], condition)) {
                 tb_ptr = ptr;
             }
             break;
@@ -1109,10 +1120,11 @@ int print_insn_tci(bfd_vma addr, disassemble_info *info)
 
     case INDEX_op_brcond_i32:
     case INDEX_op_brcond_i64:
-        tci_args_rl(insn, tb_ptr, &r0, &ptr);
-        info->fprintf_func(info->stream, "%-12s  %s, 0, ne, %p",
-                           op_name, str_r(r0), ptr);
-        break;
+        tci_args_rrcl(insn, tb_ptr, &r0, &r1, &c, &ptr);
+        info->fprintf_func(info->stream, "%-12s  %s, %s, %s, %p",
+                           op_name, str_r(r0), str_r(r1), str_c(c), ptr);
+        /* The displacement word is part of the insn. */
+        return 2 * sizeof(insn);
 
     case INDEX_op_setcond_i32:
     case INDEX_op_setcond_i64:
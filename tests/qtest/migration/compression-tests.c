@@ -205,6 +205,81 @@ static void test_multifd_tcp_zlib(void)
     test_precopy_common(&args);
 }
 
+static void *
+migrate_hook_start_precopy_tcp_multifd_xbzrle(QTestState *from,
+                                              QTestState *to)
+{
+    migrate_set_parameter_int(from, "xbzrle-cache-size", 33554432);
+
+    return migrate_hook_start_precopy_tcp_multifd_common(from, to, "xbzrle");
+}
+
+/*
+ * Memory past the area dirtied by the guest, large enough to fill
+ * several multifd packets with nothing but zero pages.
+ */
+#define XBZRLE_TEST_OFFSET (1 * 1024 * 1024)
+#define XBZRLE_TEST_SIZE   (4 * 1024 * 1024)
+
+static void xbzrle_wait_for_resend(QTestState *from)
+{
+    /* The next sync picks the writes up, the one after that sent them */
+    wait_for_migration_pass(from, get_src());
+    wait_for_migration_pass(from, get_src());
+}
+
+/*
+ * Pages must change between rounds for deltas to be sent, so this is
+ * live.  On top of the guest workload, a region goes from non-zero to
+ * zero and back to its old contents: if the source cache missed the
+ * zero pages, the delta against it would be empty and the destination
+ * would keep the zeroes.
+ */
+static void test_multifd_tcp_xbzrle(void)
+{
+    MigrateStart args = {};
+    QTestState *from, *to;
+    uint64_t addr = end_address + XBZRLE_TEST_OFFSET;
+    g_autofree uint8_t *data = g_malloc(XBZRLE_TEST_SIZE);
+    g_autofree uint8_t *dest = g_malloc(XBZRLE_TEST_SIZE);
+
+    if (migrate_start(&from, &to, "defer", &args)) {
+        return;
+    }
+
+    migrate_hook_start_precopy_tcp_multifd_xbzrle(from, to);
+
+    wait_for_serial("src_serial");
+    migrate_ensure_non_converge(from);
+    /* The guest keeps migration from converging; make the rounds short */
+    migrate_set_parameter_int(from, "max-bandwidth", 100 * 1000 * 1000);
+
+    for (size_t i = 0; i < XBZRLE_TEST_SIZE; i++) {
+        data[i] = i * 7 + 1;
+    }
+    qtest_memwrite(from, addr, data, XBZRLE_TEST_SIZE);
+
+    migrate_qmp(from, to, NULL, NULL, "{}");
+
+    /* Sent in full and cached */
+    wait_for_migration_pass(from, get_src());
+    qtest_memset(from, addr, 0, XBZRLE_TEST_SIZE);
+    xbzrle_wait_for_resend(from);
+    qtest_memwrite(from, addr, data, XBZRLE_TEST_SIZE);
+    xbzrle_wait_for_resend(from);
+
+    migrate_ensure_converge(from);
+    wait_for_migration_complete(from);
+    wait_for_stop(from, get_src());
+    wait_for_resume(to, get_dst());
+    wait_for_serial("dest_serial");
+
+    qtest_memread(to, addr, dest, XBZRLE_TEST_SIZE);
+    g_assert(memcmp(data, dest, XBZRLE_TEST_SIZE) == 0);
+
+    migrate_end(from, to, true);
+}
+
 void migration_test_add_compression(MigrationTestEnv *env)
 {
     tmpfs = env->tmpfs;
@@ -236,4 +311,6 @@ void migration_test_add_compression(MigrationTestEnv *env)
 
     migration_test_add("/migration/multifd/tcp/plain/zlib",
                        test_multifd_tcp_zlib);
+    migration_test_add("/migration/multifd/tcp/plain/xbzrle",
+                       test_multifd_tcp_xbzrle);
 }
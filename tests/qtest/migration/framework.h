@@ -214,6 +214,11 @@ void *migrate_hook_start_precopy_tcp_multifd_common(QTestState *from,
 
 typedef struct QTestMigrationState QTestMigrationState;
 QTestMigrationState *get_src(void);
+QTestMigrationState *get_dst(void);
+
+/* Guest memory dirtied by the boot file: [start_address, end_address) */
+extern unsigned start_address;
+extern unsigned end_address;
 
 #ifdef CONFIG_GNUTLS
 void migration_test_add_tls(MigrationTestEnv *env);
@@ -258,8 +258,11 @@ static void test_precopy_fd_file(void)
  *
  * To make things even worse, we need to run the initial stage at
  * 3MB/s so we enter autoconverge even when host is (over)loaded.
+ *
+ * With @adaptive, the throttle is instead computed at each sync from
+ * the dirty rate, and cpu-throttle-initial is not used.
  */
-static void test_auto_converge(void)
+static void auto_converge_common(bool adaptive)
 {
     g_autofree char *uri = g_strdup_printf("unix:%s/migsocket", tmpfs);
     MigrateStart args = {};
@@ -283,6 +286,9 @@ static void test_auto_converge(void)
     migrate_set_parameter_int(from, "cpu-throttle-initial", init_pct);
     migrate_set_parameter_int(from, "cpu-throttle-increment", inc_pct);
     migrate_set_parameter_int(from, "max-cpu-throttle", max_pct);
+    if (adaptive) {
+        migrate_set_parameter_bool(from, "cpu-throttle-adaptive", true);
+    }
 
     /*
      * Set the initial parameters so that the migration could not converge
@@ -308,8 +314,20 @@ static void test_auto_converge(void)
         usleep(20);
         g_assert_false(get_src()->stop_seen);
     } while (true);
-    /* The first percentage of throttling should be at least init_pct */
-    g_assert_cmpint(percentage, >=, init_pct);
+    if (adaptive) {
+        QDict *rsp = migrate_query_not_failed(from);
+
+        /* The target is published before the throttle is applied */
+        g_assert(qdict_haskey(rsp, "cpu-throttle-target"));
+        g_assert_cmpint(qdict_get_int(rsp, "cpu-throttle-target"), >=, 0);
+        g_assert_cmpint(qdict_get_int(rsp, "cpu-throttle-target"), <=,
+                        max_pct);
+        qobject_unref(rsp);
+        g_assert_cmpint(percentage, <=, max_pct);
+    } else {
+        /* The first percentage of throttling should be at least init_pct */
+        g_assert_cmpint(percentage, >=, init_pct);
+    }
 
     /*
      * End the loop when the dirty sync count greater than 1.
@@ -340,6 +358,10 @@ static void test_auto_converge(void)
     }
     g_assert_cmpint(hit, ==, 1);
 
+    /* The adaptive throttle has been recomputed, and stays in range */
+    percentage = read_migrate_property_int(from, "cpu-throttle-percentage");
+    g_assert_cmpint(percentage, <=, max_pct);
+
     /* Now, when we tested that throttling works, let it converge */
     migrate_ensure_converge(from);
 
@@ -362,6 +384,46 @@ static void test_auto_converge(void)
     migrate_end(from, to, true);
 }
 
+static void test_auto_converge(void)
+{
+    auto_converge_common(false);
+}
+
+static void *migrate_hook_start_defer_hot_pages(QTestState *from,
+                                                QTestState *to)
+{
+    migrate_set_capability(from, "defer-hot-pages", true);
+    return NULL;
+}
+
+/*
+ * The guest dirties its whole test area between two syncs, so after
+ * the first few iterations all of it is hot.  Most rounds then send
+ * nothing and can only make progress through the exact, syncing,
+ * pending path; and at switchover everything left is deferred pages,
+ * which the final stage must send for the destination check to pass.
+ * Each round that does send goes at 3MB/s, hence slow only.
+ */
+static void test_precopy_unix_defer_hot_pages(void)
+{
+    g_autofree char *uri = g_strdup_printf("unix:%s/migsocket", tmpfs);
+    MigrateCommon args = {
+        .connect_uri = uri,
+        .listen_uri = uri,
+        .start_hook = migrate_hook_start_defer_hot_pages,
+        /* Enough syncs for pages to turn hot and to be deferred */
+        .iterations = 6,
+        .live = true,
+    };
+
+    test_precopy_common(&args);
+}
+
+static void test_auto_converge_adaptive(void)
+{
+    auto_converge_common(true);
+}
+
 static void *
 migrate_hook_start_precopy_tcp_multifd(QTestState *from,
                                        QTestState *to)
@@ -978,6 +1040,10 @@ void migration_test_add_precopy(MigrationTestEnv *env)
     if (g_test_slow()) {
         migration_test_add("/migration/auto_converge",
                            test_auto_converge);
+        migration_test_add("/migration/auto_converge/adaptive",
+                           test_auto_converge_adaptive);
+        migration_test_add("/migration/precopy/unix/defer-hot-pages",
+                           test_precopy_unix_defer_hot_pages);
         if (g_str_equal(env->arch, "x86_64") &&
             env->has_kvm && env->has_dirty_ring) {
             migration_test_add("/dirty_limit",
@@ -0,0 +1,120 @@
+/*
+ * Check the results of the integer-only syscalls that linux-user may
+ * forward to the host unchanged: process ids, umask, lseek, fchmod,
+ * fsync and friends, including their error returns.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+#define _GNU_SOURCE
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static void test_ids(void)
+{
+    pid_t pid = getpid();
+
+    assert(pid > 0);
+    assert(syscall(SYS_getpid) == pid);
+    /* The main thread's tid is the pid */
+    assert(syscall(SYS_gettid) == pid);
+    assert(getppid() > 0 && getppid() != pid);
+
+    assert(syscall(SYS_getuid) == getuid());
+    assert(syscall(SYS_geteuid) == geteuid());
+    assert(syscall(SYS_getgid) == getgid());
+    assert(syscall(SYS_getegid) == getegid());
+
+    assert(getsid(0) > 0);
+    assert(getsid(0) == getsid(pid));
+
+    /* Become a process group leader, a session leader already is one */
+    if (getsid(0) != pid) {
+        assert(setpgid(0, 0) == 0);
+    }
+    assert(getpgid(0) == pid);
+    assert(getpgid(pid) == pid);
+
+    assert(getpgid(-1) == -1 && errno == ESRCH);
+    assert(sched_yield() == 0);
+}
+
+static void test_umask(const char *dir)
+{
+    char path[4096];
+    mode_t old;
+    struct stat st;
+    int fd;
+
+    old = umask(022);
+    assert(umask(077) == 022);
+    assert(umask(077) == 077);
+
+    snprintf(path, sizeof(path), "%s/umask", dir);
+    fd = open(path, O_CREAT | O_EXCL | O_RDWR, 0666);
+    assert(fd >= 0);
+    assert(fstat(fd, &st) == 0);
+    assert((st.st_mode & 0777) == 0600);
+    assert(st.st_uid == geteuid());
+    close(fd);
+    assert(unlink(path) == 0);
+
+    assert(umask(old) == 077);
+}
+
+static void test_file(const char *dir)
+{
+    char path[4096];
+    char buf[100];
+    const off_t len = sizeof(buf);
+    struct stat st;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/file", dir);
+    fd = open(path, O_CREAT | O_EXCL | O_RDWR, 0600);
+    assert(fd >= 0);
+    memset(buf, 'x', sizeof(buf));
+    assert(write(fd, buf, len) == len);
+
+    assert(lseek(fd, 0, SEEK_CUR) == len);
+    assert(lseek(fd, 10, SEEK_SET) == 10);
+    assert(lseek(fd, -5, SEEK_CUR) == 5);
+    assert(lseek(fd, 0, SEEK_END) == len);
+    assert(lseek(fd, 50, SEEK_END) == len + 50);
+    assert(lseek(fd, -1, SEEK_SET) == -1 && errno == EINVAL);
+    assert(lseek(-1, 0, SEEK_SET) == -1 && errno == EBADF);
+
+    assert(fchmod(fd, 0640) == 0);
+    assert(fstat(fd, &st) == 0);
+    assert((st.st_mode & 0777) == 0640);
+    assert(fchmod(-1, 0600) == -1 && errno == EBADF);
+
+    assert(fsync(fd) == 0);
+    assert(fdatasync(fd) == 0);
+    assert(fsync(-1) == -1 && errno == EBADF);
+    assert(fdatasync(-1) == -1 && errno == EBADF);
+
+    close(fd);
+    assert(unlink(path) == 0);
+}
+
+int main(void)
+{
+    char dir[] = "/tmp/qemu-passthrough-XXXXXX";
+
+    assert(mkdtemp(dir) != NULL);
+
+    test_ids();
+    test_umask(dir);
+    test_file(dir);
+
+    assert(rmdir(dir) == 0);
+    return EXIT_SUCCESS;
+}
@@ -13,6 +13,8 @@
 
 #include <qemu-plugin.h>
 
+#define NUM_INDEXED 4
+
 typedef struct {
     uint64_t count_tb;
     uint64_t count_tb_inline;
@@ -24,6 +26,10 @@ typedef struct {
     uint64_t tb_cond_track_count;
     uint64_t insn_cond_num_trigger;
     uint64_t insn_cond_track_count;
+    uint64_t insn_indexed[NUM_INDEXED];
+    uint64_t insn_max_idx;
+    uint64_t insn_min_rev_idx;
+    uint64_t insn_or_idx;
 } CPUCount;
 
 static const uint64_t cond_trigger_limit = 100;
@@ -45,6 +51,10 @@ static qemu_plugin_u64 tb_cond_num_trigger;
 static qemu_plugin_u64 tb_cond_track_count;
 static qemu_plugin_u64 insn_cond_num_trigger;
 static qemu_plugin_u64 insn_cond_track_count;
+static qemu_plugin_u64 insn_indexed;
+static qemu_plugin_u64 insn_max_idx;
+static qemu_plugin_u64 insn_min_rev_idx;
+static qemu_plugin_u64 insn_or_idx;
 static struct qemu_plugin_scoreboard *data;
 static qemu_plugin_u64 data_insn;
 static qemu_plugin_u64 data_tb;
@@ -54,6 +64,7 @@ static uint64_t global_count_tb;
 static uint64_t global_count_insn;
 static uint64_t global_count_mem;
 static unsigned int max_cpu_index;
+static size_t max_tb_insns;
 static GMutex tb_lock;
 static GMutex insn_lock;
 static GMutex mem_lock;
@@ -164,6 +175,20 @@ static void plugin_exit(qemu_plugin_id_t id, void *udata)
         g_assert(tb_cond_left == tb % cond_trigger_limit);
         g_assert(insn_cond_trigger == insn / cond_trigger_limit);
         g_assert(insn_cond_left == insn % cond_trigger_limit);
+
+        uint64_t indexed = 0;
+        for (int j = 0; j < NUM_INDEXED; j++) {
+            qemu_plugin_u64 e = insn_indexed;
+            e.offset += j * sizeof(uint64_t);
+            indexed += qemu_plugin_u64_get(e, i);
+        }
+        const uint64_t max_idx = qemu_plugin_u64_get(insn_max_idx, i);
+        const uint64_t min_rev_idx = qemu_plugin_u64_get(insn_min_rev_idx, i);
+        const uint64_t or_idx = qemu_plugin_u64_get(insn_or_idx, i);
+        g_assert(indexed == insn);
+        g_assert(max_idx < max_tb_insns);
+        g_assert(min_rev_idx == UINT64_MAX - max_idx);
+        g_assert((or_idx & 1) == (insn != 0));
     }
 
     stats_tb();
@@ -174,6 +199,17 @@ static void plugin_exit(qemu_plugin_id_t id, void *udata)
     qemu_plugin_scoreboard_free(data);
 }
 
+static void vcpu_init(qemu_plugin_id_t id, unsigned int cpu_index)
+{
+    /*
+     * linux-user reuses the index of an exited thread, so only seed the
+     * minimum once and keep it consistent with insn_max_idx.
+     */
+    if (qemu_plugin_u64_get(insn_min_rev_idx, cpu_index) == 0) {
+        qemu_plugin_u64_set(insn_min_rev_idx, cpu_index, UINT64_MAX);
+    }
+}
+
 static void vcpu_tb_exec(unsigned int cpu_index, void *udata)
 {
     qemu_plugin_u64_add(count_tb, cpu_index, 1);
@@ -239,6 +275,10 @@ static void vcpu_tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb)
         tb, vcpu_tb_cond_exec, QEMU_PLUGIN_CB_NO_REGS,
         QEMU_PLUGIN_COND_EQ, tb_cond_track_count, cond_trigger_limit, tb_store);
 
+    g_mutex_lock(&tb_lock);
+    max_tb_insns = MAX(max_tb_insns, qemu_plugin_tb_n_insns(tb));
+    g_mutex_unlock(&tb_lock);
+
     for (int idx = 0; idx < qemu_plugin_tb_n_insns(tb); ++idx) {
         struct qemu_plugin_insn *insn = qemu_plugin_tb_get_insn(tb, idx);
         void *insn_store = insn;
@@ -259,6 +299,19 @@ static void vcpu_tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb)
             QEMU_PLUGIN_COND_EQ, insn_cond_track_count, cond_trigger_limit,
             insn_store);
 
+        /* the bucket only depends on the insn, so pick it here */
+        qemu_plugin_u64 bucket = insn_indexed;
+        bucket.offset += (idx % NUM_INDEXED) * sizeof(uint64_t);
+        qemu_plugin_register_vcpu_insn_exec_inline_per_vcpu(
+            insn, QEMU_PLUGIN_INLINE_ADD_U64, bucket, 1);
+        qemu_plugin_register_vcpu_insn_exec_inline_per_vcpu(
+            insn, QEMU_PLUGIN_INLINE_MAX_U64, insn_max_idx, idx);
+        qemu_plugin_register_vcpu_insn_exec_inline_per_vcpu(
+            insn, QEMU_PLUGIN_INLINE_MIN_U64, insn_min_rev_idx,
+            UINT64_MAX - idx);
+        qemu_plugin_register_vcpu_insn_exec_inline_per_vcpu(
+            insn, QEMU_PLUGIN_INLINE_OR_U64, insn_or_idx, 1ULL << (idx % 64));
+
         qemu_plugin_register_vcpu_mem_inline_per_vcpu(
             insn, QEMU_PLUGIN_MEM_RW,
             QEMU_PLUGIN_INLINE_STORE_U64,
@@ -298,11 +351,20 @@ int qemu_plugin_install(qemu_plugin_id_t id, const qemu_info_t *info,
         counts, CPUCount, insn_cond_num_trigger);
     insn_cond_track_count = qemu_plugin_scoreboard_u64_in_struct(
         counts, CPUCount, insn_cond_track_count);
+    insn_indexed = qemu_plugin_scoreboard_u64_in_struct(
+        counts, CPUCount, insn_indexed);
+    insn_max_idx = qemu_plugin_scoreboard_u64_in_struct(
+        counts, CPUCount, insn_max_idx);
+    insn_min_rev_idx = qemu_plugin_scoreboard_u64_in_struct(
+        counts, CPUCount, insn_min_rev_idx);
+    insn_or_idx = qemu_plugin_scoreboard_u64_in_struct(
+        counts, CPUCount, insn_or_idx);
     data = qemu_plugin_scoreboard_new(sizeof(CPUData));
     data_insn = qemu_plugin_scoreboard_u64_in_struct(data, CPUData, data_insn);
     data_tb = qemu_plugin_scoreboard_u64_in_struct(data, CPUData, data_tb);
     data_mem = qemu_plugin_scoreboard_u64_in_struct(data, CPUData, data_mem);
 
+    qemu_plugin_register_vcpu_init_cb(id, vcpu_init);
     qemu_plugin_register_vcpu_tb_trans_cb(id, vcpu_tb_trans);
     qemu_plugin_register_atexit_cb(id, plugin_exit, NULL);
 
@@ -28,6 +28,8 @@ QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
 typedef struct {
     uint64_t mem_count;
     uint64_t io_count;
+    uint64_t cb_count;
+    uint64_t buffered_count;
 } CPUCount;
 
 typedef struct {
@@ -59,10 +61,16 @@ typedef struct {
 static struct qemu_plugin_scoreboard *counts;
 static qemu_plugin_u64 mem_count;
 static qemu_plugin_u64 io_count;
+static qemu_plugin_u64 cb_count;
+static qemu_plugin_u64 buffered_count;
 static bool do_inline, do_callback, do_print_accesses, do_region_summary;
-static bool do_haddr;
+static bool do_haddr, do_buffer;
 static enum qemu_plugin_mem_rw rw = QEMU_PLUGIN_MEM_RW;
 
+/* Kept small so that the buffers are drained often */
+#define MEM_BUFFER_RECORDS 64
+static struct qemu_plugin_mem_buffer *mem_buffer;
+
 
 static GMutex lock;
 static GHashTable *regions;
@@ -90,6 +98,16 @@ static void plugin_exit(qemu_plugin_id_t id, void *p)
     }
     qemu_plugin_outs(out->str);
 
+    /* Every buffer has been drained before the atexit callbacks */
+    if (do_buffer) {
+        for (int i = 0; i < qemu_plugin_num_vcpus(); i++) {
+            g_assert(qemu_plugin_u64_get(buffered_count, i) ==
+                     qemu_plugin_u64_get(cb_count, i));
+        }
+        g_string_printf(out, "buffered mem accesses: %" PRIu64 "\n",
+                        qemu_plugin_u64_sum(buffered_count));
+        qemu_plugin_outs(out->str);
+    }
 
     if (do_region_summary) {
         GList *counts = g_hash_table_get_values(regions);
@@ -253,6 +271,27 @@ static void vcpu_mem(unsigned int cpu_index, qemu_plugin_meminfo_t meminfo,
     }
 }
 
+static void vcpu_mem_count(unsigned int cpu_index,
+                           qemu_plugin_meminfo_t meminfo,
+                           uint64_t vaddr, void *udata)
+{
+    qemu_plugin_u64_add(cb_count, cpu_index, 1);
+}
+
+static void vcpu_mem_buffered(unsigned int cpu_index,
+                              const qemu_plugin_mem_record *records,
+                              size_t n, void *udata)
+{
+    g_assert(n > 0 && n <= MEM_BUFFER_RECORDS);
+    for (size_t i = 0; i < n; i++) {
+        enum qemu_plugin_mem_rw access =
+            qemu_plugin_mem_is_store(records[i].info) ?
+            QEMU_PLUGIN_MEM_W : QEMU_PLUGIN_MEM_R;
+        g_assert(access & rw);
+    }
+    qemu_plugin_u64_add(buffered_count, cpu_index, n);
+}
+
 static void print_access(unsigned int cpu_index, qemu_plugin_meminfo_t meminfo,
                          uint64_t vaddr, void *udata)
 {
@@ -310,6 +349,12 @@ static void vcpu_tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb)
                                              QEMU_PLUGIN_CB_NO_REGS,
                                              rw, NULL);
         }
+        if (do_buffer) {
+            qemu_plugin_register_vcpu_mem_buffer(insn, rw, mem_buffer);
+            qemu_plugin_register_vcpu_mem_cb(insn, vcpu_mem_count,
+                                             QEMU_PLUGIN_CB_NO_REGS,
+                                             rw, NULL);
+        }
         if (do_print_accesses) {
             /* we leak this pointer, to avoid locking to keep track of it */
             InsnInfo *insn_info = g_malloc(sizeof(InsnInfo));
@@ -364,6 +409,11 @@ QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id,
                 fprintf(stderr, "boolean argument parsing failed: %s\n", opt);
                 return -1;
             }
+        } else if (g_strcmp0(tokens[0], "buffer") == 0) {
+            if (!qemu_plugin_bool_parse(tokens[0], tokens[1], &do_buffer)) {
+                fprintf(stderr, "boolean argument parsing failed: %s\n", opt);
+                return -1;
+            }
         } else if (g_strcmp0(tokens[0], "region-summary") == 0) {
             if (!qemu_plugin_bool_parse(tokens[0], tokens[1],
                                         &do_region_summary)) {
@@ -399,6 +449,13 @@ QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id,
     mem_count = qemu_plugin_scoreboard_u64_in_struct(
         counts, CPUCount, mem_count);
     io_count = qemu_plugin_scoreboard_u64_in_struct(counts, CPUCount, io_count);
+    cb_count = qemu_plugin_scoreboard_u64_in_struct(counts, CPUCount, cb_count);
+    buffered_count = qemu_plugin_scoreboard_u64_in_struct(
+        counts, CPUCount, buffered_count);
+    if (do_buffer) {
+        mem_buffer = qemu_plugin_mem_buffer_new(id, MEM_BUFFER_RECORDS,
+                                                vcpu_mem_buffered, NULL);
+    }
     qemu_plugin_register_vcpu_tb_trans_cb(id, vcpu_tb_trans);
     qemu_plugin_register_atexit_cb(id, plugin_exit, NULL);
     return 0;
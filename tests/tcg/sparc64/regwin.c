@@ -0,0 +1,58 @@
+/*
+ * Exercise the windowed registers with deep recursion and branches, so
+ * that values live in %i/%l registers across many labels and window
+ * spills and fills.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static uint64_t __attribute__((noinline)) walk(uint64_t n, uint64_t a,
+                                               uint64_t b)
+{
+    uint64_t l0 = a ^ n, l1 = b + n, r;
+
+    if (n == 0) {
+        return a + b;
+    }
+    if (n & 1) {
+        l0 += l1;
+    } else {
+        l1 ^= l0;
+    }
+    r = walk(n - 1, l1, l0);
+    /* the locals must survive the call and the branches above */
+    return r + (l0 - (a ^ n)) + (l1 - (b + n));
+}
+
+static uint64_t walk_ref(uint64_t n, uint64_t a, uint64_t b)
+{
+    uint64_t sum = 0;
+
+    for (;;) {
+        uint64_t l0 = a ^ n, l1 = b + n;
+
+        if (n == 0) {
+            return sum + a + b;
+        }
+        if (n & 1) {
+            l0 += l1;
+        } else {
+            l1 ^= l0;
+        }
+        sum += (l0 - (a ^ n)) + (l1 - (b + n));
+        a = l1;
+        b = l0;
+        n--;
+    }
+}
+
+int main(void)
+{
+    for (uint64_t n = 1; n < 200; n += 13) {
+        assert(walk(n, n * 3, n * 7) == walk_ref(n, n * 3, n * 7));
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,51 @@
+/*
+ * Test x86_64-linux-user self-modifying code that retranslates an
+ * instruction using a TSTNE condition.
+ *
+ * The BTC below modifies its own TB, so it is re-executed on its own
+ * from a block translated with CF_NOIRQ, for which the optimizer is
+ * normally skipped.  With the flags in an unknown state BTC computes
+ * CF with a TSTNE setcond, which must still be lowered on hosts that
+ * lack TCG_TARGET_HAS_tst.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+extern uint32_t smc_imm;
+
+static void __attribute__((noinline)) flip(uint32_t *val, uint8_t *cf)
+{
+    asm volatile("jmp 0f\n"                   /* start a new TB */
+                 "0: btcl $0, smc_imm(%%rip)\n"
+                 ".byte 0xb8\n"               /* mov $imm32, %eax */
+                 ".globl smc_imm\n"
+                 "smc_imm: .long 0\n"
+                 "setc %[cf]"
+                 : "=a" (*val), [cf] "=qm" (*cf)
+                 : : "cc", "memory");
+}
+
+int main(void)
+{
+    char *start = (char *)((uintptr_t)&smc_imm & ~0xFFFULL);
+    char *end = (char *)&smc_imm + sizeof(smc_imm);
+    int err, i;
+
+    err = mprotect(start, end - start, PROT_READ | PROT_WRITE | PROT_EXEC);
+    assert(err == 0);
+
+    for (i = 0; i < 4; i++) {
+        uint32_t val;
+        uint8_t cf;
+
+        flip(&val, &cf);
+        assert(cf == (i & 1));
+        assert(val == !(i & 1));
+    }
+
+    return EXIT_SUCCESS;
+}
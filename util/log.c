@@ -505,6 +505,8 @@ const QEMULogItem qemu_log_items[] = {
       "include VPU registers in the 'cpu' logging" },
     { LOG_INVALID_MEM, "invalid_mem",
       "log invalid memory accesses" },
+    { LOG_TB_STATS, "tb_stats",
+      "linux-user only: show translation statistics on exit" },
     { 0, NULL, NULL },
 };
 